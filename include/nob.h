@@ -124,12 +124,28 @@
 #    include <windows.h>
 #    include <direct.h>
 #    include <shellapi.h>
+#    include <io.h>
 #else
 #    include <sys/types.h>
 #    include <sys/wait.h>
 #    include <sys/stat.h>
 #    include <unistd.h>
 #    include <fcntl.h>
+#    include <time.h>
+#    include <poll.h>
+#    include <sys/mman.h>
+#    include <pthread.h>
+#    include <spawn.h>
+extern char **environ;
+#endif
+
+#ifdef __linux__
+#    include <sys/ioctl.h>
+#    include <sys/sendfile.h>
+#    include <sys/syscall.h>
+#    ifndef FICLONE
+#        define FICLONE _IOW(0x94, 9, int)
+#    endif
 #endif
 
 #ifdef _WIN32
@@ -193,13 +209,50 @@ typedef enum {
 } Nob_File_Type;
 
 NOBDEF bool nob_mkdir_if_not_exists(const char *path);
+// Copies the file and gives the copy the modification time of the source. A destination that
+// already has the size and the modification time of the source is left alone. On Linux the data
+// does not go through nob: the copy is a reflink where the file system supports it, otherwise the
+// kernel copies it with copy_file_range() or sendfile().
 NOBDEF bool nob_copy_file(const char *src_path, const char *dst_path);
 NOBDEF bool nob_copy_directory_recursively(const char *src_path, const char *dst_path);
+
+typedef struct {
+    size_t copied;        // files nob_copy_file() copied
+    size_t skipped;       // files that were up to date already
+    uint64_t bytes;       // size of the copied files
+} Nob_Copy_Stats;
+
+extern Nob_Copy_Stats nob_copy_stats;
 NOBDEF bool nob_read_entire_dir(const char *parent, Nob_File_Paths *children);
 NOBDEF bool nob_write_entire_file(const char *path, const void *data, size_t size);
 NOBDEF Nob_File_Type nob_get_file_type(const char *path);
 NOBDEF bool nob_delete_file(const char *path);
 
+// What nob knows about a file without opening it. mtime_ns counts nanoseconds since the epoch of
+// the platform, inode is 0 on Windows.
+typedef struct {
+    Nob_File_Type type;
+    uint64_t mtime_ns;
+    uint64_t size;
+    uint64_t inode;
+} Nob_File_Stat;
+
+// Stats are cached for the rest of the run, so the files that the walker below has seen and every
+// input of nob_needs_rebuild() are only asked about once. nob forgets the paths it writes, renames
+// or deletes itself, and nob_needs_rebuild() forgets its output path because that is the file
+// that is about to change. If something else modifies an input after nob has looked at it (a long
+// running nob that waits for edits, for example) call nob_stat_cache_reset().
+NOBDEF bool nob_file_stat(const char *path, Nob_File_Stat *st);
+NOBDEF void nob_stat_cache_forget(const char *path);
+NOBDEF void nob_stat_cache_reset(void);
+
+// Appends every regular file under root for which filter returns true (NULL accepts everything)
+// to out, sorted, and fills the stat cache with them. Symlinks are not followed. The type of an
+// entry comes from the directory listing, so only the accepted files are stat'ed. Subdirectories
+// are read by up to `threads` threads, which means filter must be thread safe. The paths are
+// allocated with malloc, not in the temporary storage, so big trees don't overflow it.
+NOBDEF bool nob_walk_files(const char *root, Nob_File_Paths *out, bool (*filter)(const char *path), size_t threads);
+
 #define nob_return_defer(value) do { result = (value); goto defer; } while(0)
 
 // Initial capacity of a dynamic array
@@ -337,9 +390,57 @@ NOBDEF bool nob_proc_wait(Nob_Proc proc);
 NOBDEF bool nob_procs_wait(Nob_Procs procs);
 // Wait until all the processes have finished and empty the procs array
 NOBDEF bool nob_procs_wait_and_reset(Nob_Procs *procs);
-// Append a new process to procs array and if procs.count reaches max_procs_count call nob_procs_wait_and_reset() on it
+// Wait until any of the processes has finished and remove it from the procs array. The order of
+// the remaining processes is not kept. The finished process is stored into finished if it's not NULL.
+NOBDEF bool nob_procs_wait_any(Nob_Procs *procs, Nob_Proc *finished);
+// Wait until fewer than max_procs_count processes are running and, with a jobserver, until nob got
+// a job slot for starting one more. Processes are collected as soon as they finish. Returns false
+// if any of the collected processes failed.
+NOBDEF bool nob_procs_wait_for_slot(Nob_Procs *procs, size_t max_procs_count);
+// Append a new process to procs array and call nob_procs_wait_for_slot() on it, so the next process
+// can start as soon as any of the running ones has finished
 NOBDEF bool nob_procs_append_with_flush(Nob_Procs *procs, Nob_Proc proc, size_t max_procs_count);
 
+// GNU make jobserver, see https://www.gnu.org/software/make/manual/html_node/Job-Slots.html
+// nob_jobserver_init() joins the jobserver that the parent make or nob announced in MAKEFLAGS.
+// Without one nob becomes the jobserver itself with jobs slots and announces it in MAKEFLAGS, so
+// make, ninja and other nobs started from here share the slots with nob instead of each of them
+// running its own -j. Every process nob_procs_wait_for_slot() makes room for beyond the first one
+// takes a slot, the first one runs on the slot nob got implicitly.
+NOBDEF bool nob_jobserver_init(size_t jobs);
+// Whether nob_jobserver_init() joined or started a jobserver
+NOBDEF bool nob_jobserver_active(void);
+
+// Build tracing. While nob_trace.enabled is set every process started with nob_cmd_start_process()
+// is recorded from the moment it was started until nob_proc_wait() collected it.
+typedef struct {
+    char *label;          // what the process works on, like the source file of a compile command
+    char *command;        // the full rendered command
+    long long pid;
+    uint64_t start_usec;
+    uint64_t end_usec;    // 0 while the process was not waited on yet
+    bool failed;
+} Nob_Trace_Event;
+
+typedef struct {
+    Nob_Trace_Event *items;
+    size_t count;
+    size_t capacity;
+    bool enabled;
+} Nob_Trace;
+
+extern Nob_Trace nob_trace;
+
+// Microseconds from a monotonic clock with an unspecified epoch
+NOBDEF uint64_t nob_time_usec(void);
+// Writes the recorded processes in the Chrome trace event format that chrome://tracing and
+// https://ui.perfetto.dev can open. Processes that overlap in time are put on separate rows.
+NOBDEF bool nob_trace_write_json(const char *path);
+// Logs the n processes that took the longest
+NOBDEF void nob_trace_log_slowest(size_t n);
+// Frees the recorded events
+NOBDEF void nob_trace_reset(void);
+
 // A command - the main workhorse of Nob. Nob is all about building commands and running them
 typedef struct {
     const char **items;
@@ -364,6 +465,68 @@ NOBDEF bool nob_cmd_run_opt(Nob_Cmd *cmd, Nob_Cmd_Opt opt);
 // It's generally not recommended to call this function directly. Use nob_cmd_run() and nob_cmd_run_opt() instead.
 NOBDEF Nob_Proc nob_cmd_start_process(Nob_Cmd cmd, Nob_Fd *fdin, Nob_Fd *fdout, Nob_Fd *fderr);
 
+// Compilation database (https://clang.llvm.org/docs/JSONCompilationDatabase.html). While
+// nob_compdb.enabled is set every command started with nob_cmd_start_process() that compiles
+// source files is recorded with its exact arguments, once for each of the sources. That includes
+// commands that compile and link in one go, like the ones for the mobile platforms.
+typedef struct {
+    char *file;           // absolute path of the source, there is one entry per source
+    char *json;           // the entry as it is written into the database
+} Nob_Compdb_Entry;
+
+typedef struct {
+    Nob_Compdb_Entry *items;
+    size_t count;
+    size_t capacity;
+    bool enabled;
+} Nob_Compdb;
+
+extern Nob_Compdb nob_compdb;
+
+// Records a command that compiles a source without running it, like one whose outputs came from
+// the build cache. Only compiler invocations are recorded: commands with -c or -S, or ones that run
+// a C compiler (cc, gcc, clang, with or without a target prefix or version suffix) to compile and
+// link in one go. Other tools that merely take a source file as an argument are ignored.
+NOBDEF void nob_compdb_record(Nob_Cmd cmd);
+// Writes the recorded commands into the compile_commands.json at path. The sources that were not
+// compiled this time keep their entries from the databases at merge_paths, like the one cmake
+// exports with CMAKE_EXPORT_COMPILE_COMMANDS, and from the existing database at path, unless they
+// were deleted since. The database is written to a temporary file that is renamed over path, so
+// tools reading it concurrently never see half of it.
+NOBDEF bool nob_compdb_write(const char *path, const char **merge_paths, size_t merge_paths_count);
+// Frees the recorded commands
+NOBDEF void nob_compdb_reset(void);
+
+// Output of a command collected in memory through pipes instead of a file. Captures started one
+// after another run in parallel, and nob_captures_wait() drains all their pipes with one poll loop,
+// so no child blocks on a full pipe while nob waits on another one:
+//
+// ```c
+// Nob_Capture sdk = {0};
+// nob_cmd_append(&cmd, "xcrun", "--show-sdk-path");
+// if (!nob_capture_start(&cmd, false, &sdk)) fail();
+// // ...run other steps
+// if (!nob_captures_wait(&sdk, 1)) fail();
+// printf(SV_Fmt"\n", SV_Arg(nob_sv_trim(nob_sb_to_sv(sdk.out))));
+// nob_capture_free(&sdk);
+// ```
+typedef struct {
+    Nob_Proc proc;
+    Nob_String_Builder out;   // what the process wrote to its stdout
+    Nob_String_Builder err;   // what the process wrote to its stderr, if it was captured
+    Nob_Fd out_pipe;          // read ends of the pipes until the process closed them
+    Nob_Fd err_pipe;
+} Nob_Capture;
+
+// Starts the command with its stdout, and its stderr with capture_stderr, going into pipes and
+// resets cmd. Without capture_stderr the errors go to nob's stderr like for any other command.
+NOBDEF bool nob_capture_start(Nob_Cmd *cmd, bool capture_stderr, Nob_Capture *capture);
+// Reads the pipes of all the captures until the processes closed them, then waits for them
+NOBDEF bool nob_captures_wait(Nob_Capture *captures, size_t count);
+// Runs the command, appending its stdout to out and its stderr to err unless err is NULL, and resets cmd
+NOBDEF bool nob_cmd_run_capture(Nob_Cmd *cmd, Nob_String_Builder *out, Nob_String_Builder *err);
+NOBDEF void nob_capture_free(Nob_Capture *capture);
+
 // DEPRECATED:
 //
 // You were suppose to use this structure like this:
@@ -465,9 +628,13 @@ NOB_DEPRECATED("Use nob_cmd_run(&cmd, "
                ".stderr = &fderr); instead.")
 NOBDEF bool nob_cmd_run_sync_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect);
 
-#ifndef NOB_TEMP_CAPACITY
-#define NOB_TEMP_CAPACITY (8*1024*1024)
-#endif // NOB_TEMP_CAPACITY
+// The temporary storage is a chain of blocks that are mapped when the previous ones are full, so it
+// never runs out and costs nothing until it is used. Allocations bigger than a block get a block of
+// their own. Every thread has its own chain: threads may use the nob_temp_* functions freely, as
+// long as they call nob_temp_release() before they exit.
+#ifndef NOB_TEMP_BLOCK_SIZE
+#define NOB_TEMP_BLOCK_SIZE (1024*1024)
+#endif // NOB_TEMP_BLOCK_SIZE
 NOBDEF char *nob_temp_strdup(const char *cstr);
 NOBDEF void *nob_temp_alloc(size_t size);
 NOBDEF char *nob_temp_sprintf(const char *format, ...) NOB_PRINTF_FORMAT(1, 2);
@@ -495,13 +662,84 @@ NOBDEF char *nob_temp_sprintf(const char *format, ...) NOB_PRINTF_FORMAT(1, 2);
 NOBDEF void nob_temp_reset(void);
 NOBDEF size_t nob_temp_save(void);
 NOBDEF void nob_temp_rewind(size_t checkpoint);
+// Unmaps all the blocks of the calling thread
+NOBDEF void nob_temp_release(void);
+
+typedef struct {
+    size_t high_water;    // the most bytes the storage held at once, counting the unused ends of full blocks
+    size_t mapped;        // bytes mapped right now
+    size_t blocks;        // blocks mapped right now
+} Nob_Temp_Stats;
+
+// Statistics of the temporary storage of the calling thread
+NOBDEF Nob_Temp_Stats nob_temp_stats(void);
 
 // Given any path returns the last part of that path.
 // "/path/to/a/file.c" -> "file.c"; "/path/to/a/directory" -> "directory"
 NOBDEF const char *nob_path_name(const char *path);
 NOBDEF bool nob_rename(const char *old_path, const char *new_path);
+// Compares modification times at the full resolution of the file system. See nob_manifest_load() for
+// only rebuilding when the content of the inputs changed.
 NOBDEF int nob_needs_rebuild(const char *output_path, const char **input_paths, size_t input_paths_count);
 NOBDEF int nob_needs_rebuild1(const char *output_path, const char *input_path);
+// Parse a Makefile-style dependency file produced by the compiler (see nob_cc_depfile()) and append
+// all the prerequisites of its first rule to deps. The paths are allocated in the temporary storage.
+NOBDEF bool nob_read_depfile(const char *depfile_path, Nob_File_Paths *deps);
+// Just like nob_needs_rebuild() but takes the inputs from the dependency file that was generated
+// together with the output. Missing depfile or missing prerequisites mean that the output must be rebuilt.
+NOBDEF int nob_needs_rebuild_depfile(const char *output_path, const char *depfile_path);
+
+// 64-bit FNV-1a. Start with NOB_HASH_INIT and feed the previous result back in to hash several buffers.
+#define NOB_HASH_INIT 14695981039346656037ULL
+NOBDEF uint64_t nob_hash_bytes(uint64_t hash, const void *data, size_t size);
+// Hash the contents of a file into the running hash
+NOBDEF bool nob_hash_file(const char *path, uint64_t *hash);
+
+// Content-addressed build cache in the spirit of ccache. The key of a compilation is the hash of
+// the rendered command, the size and time of the compiler binary and the preprocessed source, so
+// it survives `git checkout` and mtime changes but not a compiler upgrade:
+//
+// ```c
+// uint64_t key;
+// if (!nob_cache_key(compile_cmd, "build/main.i", &key)) fail();   // main.i is the output of `cc -E`
+// const char *outputs[] = { "build/main.o", "build/main.d" };
+// int hit = nob_cache_fetch(key, outputs, NOB_ARRAY_LEN(outputs));
+// if (hit < 0) fail();
+// if (!hit) {
+//     if (!nob_cmd_run(&compile_cmd)) fail();
+//     if (!nob_cache_store(key, outputs, NOB_ARRAY_LEN(outputs))) fail();
+// }
+// ```
+//
+// Entries are stored and restored as copies (reflinks where the file system has them) that are
+// renamed into place, so a compiler or linker that writes its output in place can't change what
+// the cache holds. nob_cache_fetch() removes the existing outputs on a miss.
+#ifndef NOB_CACHE_DIR
+#define NOB_CACHE_DIR ".nob_cache"
+#endif // NOB_CACHE_DIR
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+} Nob_Cache_Stats;
+
+extern Nob_Cache_Stats nob_cache_stats;
+
+NOBDEF bool nob_cache_key(Nob_Cmd cmd, const char *preprocessed_path, uint64_t *key);
+// RETURNS:
+//  1 - all the outputs were restored from the cache
+//  0 - cache miss. The outputs are removed
+// -1 - error. The error is logged
+NOBDEF int nob_cache_fetch(uint64_t key, const char **output_paths, size_t output_paths_count);
+NOBDEF bool nob_cache_store(uint64_t key, const char **output_paths, size_t output_paths_count);
+
+// Once the cache grows over NOB_CACHE_MAX_SIZE bytes nob_cache_trim() removes the least recently
+// used entries until it is down to three quarters of that. A hit counts as a use.
+#ifndef NOB_CACHE_MAX_SIZE
+#define NOB_CACHE_MAX_SIZE (1024ull*1024*1024)
+#endif // NOB_CACHE_MAX_SIZE
+NOBDEF bool nob_cache_trim(void);
+
 NOBDEF int nob_file_exists(const char *file_path);
 NOBDEF const char *nob_get_current_dir_temp(void);
 NOBDEF bool nob_set_current_dir(const char *path);
@@ -546,6 +784,15 @@ NOBDEF bool nob_set_current_dir(const char *path);
 #  define nob_cc_inputs(cmd, ...) nob_cmd_append(cmd, __VA_ARGS__)
 #endif // nob_cc_inputs
 
+// Ask the compiler to write the list of the user headers the translation unit includes into depfile_path
+// as a side effect of the compilation. Use nob_needs_rebuild_depfile() to check it later.
+// Unlike the macros above these are the flags of the compiler that is driven, which is not
+// necessarily the one nob was built with, and only gcc and clang write depfiles. MSVC reports
+// the includes through /showIncludes or /sourceDependencies instead.
+#ifndef nob_cc_depfile
+#  define nob_cc_depfile(cmd, depfile_path) nob_cmd_append(cmd, "-MMD", "-MF", (depfile_path))
+#endif // nob_cc_depfile
+
 // TODO: add MinGW support for Go Rebuild Urself™ Technology and all the nob_cc_* macros above
 //   Musializer contributors came up with a pretty interesting idea of an optional prefix macro which could be useful for
 //   MinGW support:
@@ -627,6 +874,172 @@ NOBDEF Nob_String_View nob_sv_from_parts(const char *data, size_t count);
 // nob_sb_to_sv() enables you to just view Nob_String_Builder as Nob_String_View
 #define nob_sb_to_sv(sb) nob_sv_from_parts((sb).items, (sb).count)
 
+// Map the whole file at path into memory read-only and view it as a Nob_String_View instead of
+// copying it like nob_read_entire_file() does. The view is not NUL-terminated, parse it with the
+// nob_sv_* functions. Release it with nob_unmap_file(). Don't map files that something else may
+// truncate while you look at them, reading the lost pages kills the process with SIGBUS.
+NOBDEF bool nob_map_file(const char *path, Nob_String_View *view);
+NOBDEF void nob_unmap_file(Nob_String_View view);
+
+// Open-addressing hash map keyed by Nob_String_View. Any struct with items, count and capacity is a
+// map as long as the key is the first field of its items:
+//
+// ```c
+// typedef struct {
+//     Nob_String_View key;
+//     int value;
+// } Entry;
+//
+// typedef struct {
+//     Entry *items;
+//     size_t count;
+//     size_t capacity;
+// } Map;
+//
+// Map map = {0};
+// Entry *e = nob_ht_put(&map, nob_sv_from_cstr("foo"));
+// e->value = 69;
+// e = nob_ht_get(&map, nob_sv_from_cstr("foo"));   // NULL when the key is not there
+// nob_ht_remove(&map, nob_sv_from_cstr("foo"));
+// nob_ht_foreach(Entry, it, &map) printf(SV_Fmt" = %d\n", SV_Arg(it->key), it->value);
+// nob_ht_free(map);
+// ```
+//
+// items is the table itself: capacity is its size and the empty slots have key.data == NULL.
+// nob_ht_put() returns the existing entry for the key or a zeroed new one. The map does not copy
+// the keys, intern them with nob_intern() if they don't outlive it. nob_ht_put() and
+// nob_ht_remove() move the entries around, so don't keep pointers to them across these calls.
+#define nob_ht_get(ht, key) \
+    (NOB_DECLTYPE_CAST((ht)->items) nob__ht_find((void**)&(ht)->items, &(ht)->count, &(ht)->capacity, sizeof(*(ht)->items), (key), false))
+#define nob_ht_put(ht, key) \
+    (NOB_DECLTYPE_CAST((ht)->items) nob__ht_find((void**)&(ht)->items, &(ht)->count, &(ht)->capacity, sizeof(*(ht)->items), (key), true))
+// Returns false when the key was not there
+#define nob_ht_remove(ht, key) \
+    nob__ht_remove((ht)->items, &(ht)->count, (ht)->capacity, sizeof(*(ht)->items), (key))
+#define nob_ht_foreach(Type, it, ht) \
+    for (Type *it = (ht)->items; it < (ht)->items + (ht)->capacity; ++it) if (it->key.data != NULL)
+#define nob_ht_free(ht) NOB_FREE((ht).items)
+
+// Size of a map after the first nob_ht_put(), must be a power of two
+#ifndef NOB_HT_INIT_CAP
+#define NOB_HT_INIT_CAP 64
+#endif // NOB_HT_INIT_CAP
+
+NOBDEF uint64_t nob_sv_hash(Nob_String_View sv);
+NOBDEF void *nob__ht_find(void **items, size_t *count, size_t *capacity, size_t item_size, Nob_String_View key, bool insert);
+NOBDEF bool nob__ht_remove(void *items, size_t *count, size_t capacity, size_t item_size, Nob_String_View key);
+
+#ifndef NOB_INTERN_BLOCK_SIZE
+#define NOB_INTERN_BLOCK_SIZE (64*1024)
+#endif // NOB_INTERN_BLOCK_SIZE
+
+typedef struct {
+    Nob_String_View key;
+} Nob_Interned;
+
+// Keeps one copy of every string it was given. Equal strings intern to the same pointer, so
+// interned views can be compared with a.data == b.data, and they stay valid until
+// nob_interner_free(). The copies are NUL-terminated.
+typedef struct {
+    Nob_Interned *items;
+    size_t count;
+    size_t capacity;
+    char *block;              // the copies live in blocks, each one starts with a pointer to the previous
+    size_t block_used;
+    size_t block_capacity;
+} Nob_Interner;
+
+NOBDEF Nob_String_View nob_intern(Nob_Interner *interner, Nob_String_View sv);
+NOBDEF void nob_interner_free(Nob_Interner *interner);
+
+// Content check for nob_needs_rebuild(). Once nob_manifest_load() was called, an output whose inputs
+// are newer than it is only rebuilt if their content changed since the output was built. The
+// manifest remembers the content hash of every input (keyed by its mtime and size, so a file is
+// only hashed again after it was modified) and, for every output that was up to date, the combined
+// hash of its inputs. Touching a file or checking out the same content again rebuilds nothing.
+typedef struct {
+    Nob_String_View key;      // interned path, outputs have the hash of their input paths appended
+    uint64_t hash;
+    uint64_t mtime_ns;        // of the input for files, of the output for outputs
+    uint64_t size;            // of the input for files, the number of inputs for outputs
+} Nob_Manifest_Entry;
+
+typedef struct {
+    Nob_Manifest_Entry *items;
+    size_t count;
+    size_t capacity;
+} Nob_Manifest_Entries;
+
+typedef struct {
+    bool enabled;
+    bool dirty;
+    const char *path;
+    Nob_Manifest_Entries files;
+    Nob_Manifest_Entries outputs;
+    Nob_Interner paths;
+} Nob_Manifest;
+
+extern Nob_Manifest nob_manifest;
+
+// Enables the content check and reads the manifest at path, which does not have to exist yet
+NOBDEF bool nob_manifest_load(const char *path);
+// Writes the manifest back if anything changed
+NOBDEF bool nob_manifest_save(void);
+
+// ZIP archives written by nob itself, for the packages of the mobile platforms. Entries are stored
+// as they are: files are added uncompressed, and entries copied from another archive keep their
+// compression. An archive that already exists is updated in place: an entry whose content did not
+// change is kept where it is, a changed one is written at the end, and entries that were not added
+// again are dropped on nob_zip_close(). An archive where nothing changed is not touched at all:
+//
+// ```c
+// Nob_Zip apk = {0};
+// if (!nob_zip_open(&apk, "build/app-unsigned.apk")) fail();
+// nob_zip_add_zip(&apk, "build/resources.apk");                       // the output of aapt2 link
+// nob_zip_add_file(&apk, "classes.dex", "build/classes.dex", 4);
+// nob_zip_add_file(&apk, "lib/arm64-v8a/libmain.so", "build/libmain.so", 16*1024);
+// if (!nob_zip_close(&apk)) fail();
+// ```
+//
+// The archive must stay under 2 GiB, there is no ZIP64.
+typedef struct {
+    char *name;
+    uint16_t method;          // 0 for stored, 8 for deflated
+    uint32_t crc32;
+    uint32_t compressed_size;
+    uint32_t size;
+    uint32_t offset;          // of the local header
+    uint32_t end;             // of the data
+    uint16_t alignment;       // of the data of a stored entry
+    bool used;                // added since nob_zip_open()
+} Nob_Zip_Entry;
+
+typedef struct {
+    Nob_Zip_Entry *items;
+    size_t count;
+    size_t capacity;
+    const char *path;
+    FILE *file;
+    uint32_t append_offset;   // where the next changed entry goes
+    size_t kept;              // entries that were unchanged
+    size_t written;           // entries that were written
+    bool changed;             // false if nob_zip_close() left the archive as it was
+    bool failed;              // an entry could not be added, nob_zip_close() deletes the archive
+} Nob_Zip;
+
+NOBDEF uint32_t nob_crc32(uint32_t crc, const void *data, size_t size);
+// Opens the archive at path for updating, or creates it
+NOBDEF bool nob_zip_open(Nob_Zip *zip, const char *path);
+// Adds the file at path as the stored entry name. Its data starts at a multiple of alignment, which
+// has to be a power of two up to 32 KiB: 4 for what is memory mapped from APKs, the page size for
+// native libraries. 0 means no alignment.
+NOBDEF bool nob_zip_add_file(Nob_Zip *zip, const char *name, const char *path, size_t alignment);
+// Adds all the entries of the archive at path without recompressing them. Stored ones are 4-byte aligned.
+NOBDEF bool nob_zip_add_zip(Nob_Zip *zip, const char *path);
+// Drops the entries that were not added, writes the central directory and closes the archive. If any
+// add failed, the archive may hold half written data under a matching CRC, so it is deleted instead.
+NOBDEF bool nob_zip_close(Nob_Zip *zip);
+
 // printf macros for String_View
 #ifndef SV_Fmt
 #define SV_Fmt "%.*s"
@@ -807,8 +1220,30 @@ NOBDEF void nob__go_rebuild_urself(int argc, char **argv, const char *source_pat
     exit(0);
 }
 
-static size_t nob_temp_size = 0;
-static char nob_temp[NOB_TEMP_CAPACITY] = {0};
+#if defined(__cplusplus)
+#    define NOB__THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#    define NOB__THREAD_LOCAL __declspec(thread)
+#else
+#    define NOB__THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct Nob__Temp_Block Nob__Temp_Block;
+struct Nob__Temp_Block {
+    Nob__Temp_Block *prev;
+    Nob__Temp_Block *next;    // kept after a rewind, the next allocations reuse it
+    size_t base;              // where the block starts in the positions nob_temp_save() returns
+    size_t capacity;
+    size_t used;
+};
+
+typedef struct {
+    Nob__Temp_Block *first;
+    Nob__Temp_Block *current;
+    Nob_Temp_Stats stats;
+} Nob__Temp;
+
+static NOB__THREAD_LOCAL Nob__Temp nob__temp = {0};
 
 NOBDEF bool nob_mkdir_if_not_exists(const char *path)
 {
@@ -830,21 +1265,86 @@ NOBDEF bool nob_mkdir_if_not_exists(const char *path)
     return true;
 }
 
+Nob_Copy_Stats nob_copy_stats = {0};
+
+#ifdef _WIN32
+static bool nob__copy_is_up_to_date(const char *src_path, const char *dst_path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA src, dst;
+    if (!GetFileAttributesExA(src_path, GetFileExInfoStandard, &src)) return false;
+    if (!GetFileAttributesExA(dst_path, GetFileExInfoStandard, &dst)) return false;
+    return src.nFileSizeLow == dst.nFileSizeLow && src.nFileSizeHigh == dst.nFileSizeHigh
+        && CompareFileTime(&src.ftLastWriteTime, &dst.ftLastWriteTime) == 0;
+}
+#else
+#ifdef __APPLE__
+#    define nob__st_mtim(st) (st).st_mtimespec
+#else
+#    define nob__st_mtim(st) (st).st_mtim
+#endif // __APPLE__
+
+static bool nob__copy_is_up_to_date(const struct stat *src, const char *dst_path)
+{
+    struct stat dst;
+    if (stat(dst_path, &dst) < 0) return false;
+    return S_ISREG(dst.st_mode) && dst.st_size == src->st_size
+        && nob__st_mtim(dst).tv_sec == nob__st_mtim(*src).tv_sec
+        && nob__st_mtim(dst).tv_nsec == nob__st_mtim(*src).tv_nsec;
+}
+#endif // _WIN32
+
+#ifdef __linux__
+// Lets the kernel copy as much as it can, starting at the current offsets of both files, and
+// returns how much it copied. Whatever is left goes through nob's own buffer.
+static off_t nob__copy_file_in_kernel(int src_fd, int dst_fd, off_t size)
+{
+    // shares the blocks on file systems that support it, like btrfs and xfs, so nothing is copied at all
+    if (ioctl(dst_fd, FICLONE, src_fd) == 0) return size;
+
+    off_t copied = 0;
+#ifdef SYS_copy_file_range
+    // stays inside the kernel and lets file systems like nfs copy on the server
+    while (copied < size) {
+        long n = syscall(SYS_copy_file_range, src_fd, NULL, dst_fd, NULL, (size_t)(size - copied), 0);
+        if (n <= 0) break;
+        copied += n;
+    }
+#endif // SYS_copy_file_range
+    // older kernels can't copy_file_range() across file systems
+    while (copied < size) {
+        ssize_t n = sendfile(dst_fd, src_fd, NULL, (size_t)(size - copied));
+        if (n <= 0) break;
+        copied += n;
+    }
+    return copied;
+}
+#endif // __linux__
+
 NOBDEF bool nob_copy_file(const char *src_path, const char *dst_path)
 {
-    nob_log(NOB_INFO, "copying %s -> %s", src_path, dst_path);
+    nob_stat_cache_forget(dst_path);
 #ifdef _WIN32
+    if (nob__copy_is_up_to_date(src_path, dst_path)) {
+        nob_copy_stats.skipped += 1;
+        return true;
+    }
+    nob_log(NOB_INFO, "copying %s -> %s", src_path, dst_path);
+    // CopyFile() keeps the modification time already
     if (!CopyFile(src_path, dst_path, FALSE)) {
         nob_log(NOB_ERROR, "Could not copy file: %s", nob_win32_error_message(GetLastError()));
         return false;
     }
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (GetFileAttributesExA(dst_path, GetFileExInfoStandard, &attributes)) {
+        nob_copy_stats.bytes += ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    }
+    nob_copy_stats.copied += 1;
     return true;
 #else
     int src_fd = -1;
     int dst_fd = -1;
     size_t buf_size = 32*1024;
-    char *buf = (char*)NOB_REALLOC(NULL, buf_size);
-    NOB_ASSERT(buf != NULL && "Buy more RAM lol!!");
+    char *buf = NULL;
     bool result = true;
 
     src_fd = open(src_path, O_RDONLY);
@@ -859,19 +1359,35 @@ NOBDEF bool nob_copy_file(const char *src_path, const char *dst_path)
         nob_return_defer(false);
     }
 
+    if (nob__copy_is_up_to_date(&src_stat, dst_path)) {
+        nob_copy_stats.skipped += 1;
+        nob_return_defer(true);
+    }
+    nob_log(NOB_INFO, "copying %s -> %s", src_path, dst_path);
+
     dst_fd = open(dst_path, O_CREAT | O_TRUNC | O_WRONLY, src_stat.st_mode);
     if (dst_fd < 0) {
         nob_log(NOB_ERROR, "Could not create file %s: %s", dst_path, strerror(errno));
         nob_return_defer(false);
     }
 
-    for (;;) {
+    off_t copied = 0;
+#ifdef __linux__
+    copied = nob__copy_file_in_kernel(src_fd, dst_fd, src_stat.st_size);
+#endif // __linux__
+
+    if (copied < src_stat.st_size) {
+        buf = (char*)NOB_REALLOC(NULL, buf_size);
+        NOB_ASSERT(buf != NULL && "Buy more RAM lol!!");
+    }
+    while (copied < src_stat.st_size) {
         ssize_t n = read(src_fd, buf, buf_size);
         if (n == 0) break;
         if (n < 0) {
             nob_log(NOB_ERROR, "Could not read from file %s: %s", src_path, strerror(errno));
             nob_return_defer(false);
         }
+        copied += n;
         char *buf2 = buf;
         while (n > 0) {
             ssize_t m = write(dst_fd, buf2, n);
@@ -884,10 +1400,19 @@ NOBDEF bool nob_copy_file(const char *src_path, const char *dst_path)
         }
     }
 
+    // the modification time is what tells the next copy that this one is up to date
+    struct timespec times[2] = { nob__st_mtim(src_stat), nob__st_mtim(src_stat) };
+    if (futimens(dst_fd, times) < 0) {
+        nob_log(NOB_ERROR, "Could not set the modification time of %s: %s", dst_path, strerror(errno));
+        nob_return_defer(false);
+    }
+    nob_copy_stats.copied += 1;
+    nob_copy_stats.bytes += (uint64_t)copied;
+
 defer:
     NOB_FREE(buf);
-    close(src_fd);
-    close(dst_fd);
+    if (src_fd >= 0) close(src_fd);
+    if (dst_fd >= 0) close(dst_fd);
     return result;
 #endif
 }
@@ -980,315 +1505,606 @@ NOBDEF bool nob_cmd_run_opt(Nob_Cmd *cmd, Nob_Cmd_Opt opt)
 
     return true;
 }
-NOBDEF Nob_Proc nob_cmd_run_async_redirect(Nob_Cmd cmd, Nob_Cmd_Redirect redirect)
-{
-    return nob_cmd_start_process(cmd, redirect.fdin, redirect.fdout, redirect.fderr);
-}
+Nob_Trace nob_trace = {0};
 
-NOBDEF Nob_Proc nob_cmd_start_process(Nob_Cmd cmd, Nob_Fd *fdin, Nob_Fd *fdout, Nob_Fd *fderr)
+NOBDEF uint64_t nob_time_usec(void)
 {
-    if (cmd.count < 1) {
-        nob_log(NOB_ERROR, "Could not run empty command");
-        return NOB_INVALID_PROC;
-    }
-
-    Nob_String_Builder sb = {0};
-    nob_cmd_render(cmd, &sb);
-    nob_sb_append_null(&sb);
-    nob_log(NOB_INFO, "CMD: %s", sb.items);
-    nob_sb_free(sb);
-    memset(&sb, 0, sizeof(sb));
-
 #ifdef _WIN32
-    // https://docs.microsoft.com/en-us/windows/win32/procthread/creating-a-child-process-with-redirected-input-and-output
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000
+                      + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
 
-    STARTUPINFO siStartInfo;
-    ZeroMemory(&siStartInfo, sizeof(siStartInfo));
-    siStartInfo.cb = sizeof(STARTUPINFO);
-    // NOTE: theoretically setting NULL to std handles should not be a problem
-    // https://docs.microsoft.com/en-us/windows/console/getstdhandle?redirectedfrom=MSDN#attachdetach-behavior
-    // TODO: check for errors in GetStdHandle
-    siStartInfo.hStdError = fderr ? *fderr : GetStdHandle(STD_ERROR_HANDLE);
-    siStartInfo.hStdOutput = fdout ? *fdout : GetStdHandle(STD_OUTPUT_HANDLE);
-    siStartInfo.hStdInput = fdin ? *fdin : GetStdHandle(STD_INPUT_HANDLE);
-    siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
+// the program followed by the input after -c or -E, otherwise the output after -o
+static char *nob__trace_label(Nob_Cmd cmd)
+{
+    const char *program = cmd.items[0];
+    const char *slash = strrchr(program, '/');
+    if (slash != NULL) program = slash + 1;
 
-    PROCESS_INFORMATION piProcInfo;
-    ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
+    const char *target = NULL;
+    for (size_t i = 0; i + 1 < cmd.count; ++i) {
+        if (strcmp(cmd.items[i], "-o") == 0) target = cmd.items[i + 1];
+    }
+    for (size_t i = 0; i < cmd.count; ++i) {
+        if (strcmp(cmd.items[i], "-c") == 0 && i + 1 < cmd.count) target = cmd.items[i + 1];
+        if (strcmp(cmd.items[i], "-E") == 0) target = cmd.items[cmd.count - 1];
+    }
 
-    nob__win32_cmd_quote(cmd, &sb);
-    nob_sb_append_null(&sb);
-    BOOL bSuccess = CreateProcessA(NULL, sb.items, NULL, NULL, TRUE, 0, NULL, NULL, &siStartInfo, &piProcInfo);
-    nob_sb_free(sb);
+    size_t size = strlen(program) + (target ? strlen(target) + 1 : 0) + 1;
+    char *result = malloc(size);
+    NOB_ASSERT(result != NULL);
+    snprintf(result, size, "%s%s%s", program, target ? " " : "", target ? target : "");
+    return result;
+}
 
-    if (!bSuccess) {
-        nob_log(NOB_ERROR, "Could not create child process for %s: %s", cmd.items[0], nob_win32_error_message(GetLastError()));
-        return NOB_INVALID_PROC;
+static void nob__json_escape(Nob_String_Builder *sb, const char *s)
+{
+    for (; *s; ++s) {
+        switch (*s) {
+            case '"':  nob_sb_append_cstr(sb, "\\\""); break;
+            case '\\': nob_sb_append_cstr(sb, "\\\\"); break;
+            case '\n': nob_sb_append_cstr(sb, "\\n");  break;
+            case '\t': nob_sb_append_cstr(sb, "\\t");  break;
+            default:
+                if ((unsigned char)*s < 0x20) {
+                    nob_sb_append_cstr(sb, nob_temp_sprintf("\\u%04x", (unsigned char)*s));
+                } else {
+                    nob_da_append(sb, *s);
+                }
+        }
     }
+}
 
-    CloseHandle(piProcInfo.hThread);
+static int nob__compare_trace_by_start(const void *a, const void *b)
+{
+    uint64_t sa = ((const Nob_Trace_Event*)a)->start_usec;
+    uint64_t sb = ((const Nob_Trace_Event*)b)->start_usec;
+    return (sa > sb) - (sa < sb);
+}
 
-    return piProcInfo.hProcess;
-#else
-    pid_t cpid = fork();
-    if (cpid < 0) {
-        nob_log(NOB_ERROR, "Could not fork child process: %s", strerror(errno));
-        return NOB_INVALID_PROC;
-    }
+static uint64_t nob__trace_duration(const Nob_Trace_Event *event)
+{
+    return event->end_usec > event->start_usec ? event->end_usec - event->start_usec : 0;
+}
 
-    if (cpid == 0) {
-        if (fdin) {
-            if (dup2(*fdin, STDIN_FILENO) < 0) {
-                nob_log(NOB_ERROR, "Could not setup stdin for child process: %s", strerror(errno));
-                exit(1);
-            }
-        }
+static int nob__compare_trace_by_duration(const void *a, const void *b)
+{
+    uint64_t da = nob__trace_duration(a);
+    uint64_t db = nob__trace_duration(b);
+    return (da < db) - (da > db);
+}
 
-        if (fdout) {
-            if (dup2(*fdout, STDOUT_FILENO) < 0) {
-                nob_log(NOB_ERROR, "Could not setup stdout for child process: %s", strerror(errno));
-                exit(1);
-            }
-        }
+// sorted copy of the recorded events
+static Nob_Trace_Event *nob__trace_sorted(int (*compare)(const void*, const void*))
+{
+    Nob_Trace_Event *events = malloc((nob_trace.count + 1) * sizeof(*events));
+    NOB_ASSERT(events != NULL);
+    if (nob_trace.count > 0) memcpy(events, nob_trace.items, nob_trace.count * sizeof(*events));
+    qsort(events, nob_trace.count, sizeof(*events), compare);
+    return events;
+}
 
-        if (fderr) {
-            if (dup2(*fderr, STDERR_FILENO) < 0) {
-                nob_log(NOB_ERROR, "Could not setup stderr for child process: %s", strerror(errno));
-                exit(1);
-            }
-        }
+NOBDEF bool nob_trace_write_json(const char *path)
+{
+    Nob_Trace_Event *events = nob__trace_sorted(nob__compare_trace_by_start);
 
-        // NOTE: This leaks a bit of memory in the child process.
-        // But do we actually care? It's a one off leak anyway...
-        Nob_Cmd cmd_null = {0};
-        nob_da_append_many(&cmd_null, cmd.items, cmd.count);
-        nob_cmd_append(&cmd_null, NULL);
+    // every row holds the end of the last process put on it
+    uint64_t *rows = NULL;
+    size_t rows_count = 0;
+    uint64_t origin = nob_trace.count > 0 ? events[0].start_usec : 0;
 
-        if (execvp(cmd.items[0], (char * const*) cmd_null.items) < 0) {
-            nob_log(NOB_ERROR, "Could not exec child process for %s: %s", cmd.items[0], strerror(errno));
-            exit(1);
+    Nob_String_Builder sb = {0};
+    nob_sb_append_cstr(&sb, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < nob_trace.count; ++i) {
+        Nob_Trace_Event *event = &events[i];
+        uint64_t end = event->end_usec ? event->end_usec : event->start_usec;
+
+        size_t row = 0;
+        while (row < rows_count && rows[row] > event->start_usec) row += 1;
+        if (row == rows_count) {
+            rows = realloc(rows, ++rows_count * sizeof(*rows));
+            NOB_ASSERT(rows != NULL);
         }
-        NOB_UNREACHABLE("nob_cmd_run_async_redirect");
+        rows[row] = end;
+
+        size_t mark = nob_temp_save();
+        nob_sb_append_cstr(&sb, "{\"name\":\"");
+        nob__json_escape(&sb, event->label);
+        nob_sb_append_cstr(&sb, nob_temp_sprintf("\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%zu,\"args\":{\"pid\":%lld,\"cmd\":\"",
+                                                 event->failed ? "failed" : "process",
+                                                 (unsigned long long)(event->start_usec - origin),
+                                                 (unsigned long long)(end - event->start_usec),
+                                                 row + 1, event->pid));
+        nob__json_escape(&sb, event->command);
+        nob_sb_append_cstr(&sb, i + 1 < nob_trace.count ? "\"}},\n" : "\"}}\n");
+        nob_temp_rewind(mark);
     }
+    nob_sb_append_cstr(&sb, "]}\n");
 
-    return cpid;
-#endif
+    bool result = nob_write_entire_file(path, sb.items, sb.count);
+    nob_sb_free(sb);
+    free(rows);
+    free(events);
+    return result;
 }
 
-NOBDEF Nob_Proc nob_cmd_run_async(Nob_Cmd cmd)
+NOBDEF void nob_trace_log_slowest(size_t n)
 {
-    return nob_cmd_start_process(cmd, NULL, NULL, NULL);
+    if (nob_trace.count == 0) return;
+    Nob_Trace_Event *events = nob__trace_sorted(nob__compare_trace_by_duration);
+
+    nob_log(NOB_INFO, "Slowest steps:");
+    for (size_t i = 0; i < n && i < nob_trace.count; ++i) {
+        nob_log(NOB_INFO, "  %8.3fs %s", (double)nob__trace_duration(&events[i]) / 1000000.0, events[i].label);
+    }
+    free(events);
 }
 
-NOBDEF Nob_Proc nob_cmd_run_async_and_reset(Nob_Cmd *cmd)
+NOBDEF void nob_trace_reset(void)
 {
-    Nob_Proc proc = nob_cmd_start_process(*cmd, NULL, NULL, NULL);
-    cmd->count = 0;
-    return proc;
+    for (size_t i = 0; i < nob_trace.count; ++i) {
+        free(nob_trace.items[i].label);
+        free(nob_trace.items[i].command);
+    }
+    nob_trace.count = 0;
 }
 
-NOBDEF Nob_Proc nob_cmd_run_async_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect)
+Nob_Compdb nob_compdb = {0};
+
+static bool nob__is_source_file(const char *path)
 {
-    Nob_Proc proc = nob_cmd_start_process(*cmd, redirect.fdin, redirect.fdout, redirect.fderr);
-    cmd->count = 0;
-    if (redirect.fdin) {
-        nob_fd_close(*redirect.fdin);
-        *redirect.fdin = NOB_INVALID_FD;
-    }
-    if (redirect.fdout) {
-        nob_fd_close(*redirect.fdout);
-        *redirect.fdout = NOB_INVALID_FD;
-    }
-    if (redirect.fderr) {
-        nob_fd_close(*redirect.fderr);
-        *redirect.fderr = NOB_INVALID_FD;
+    const char *extensions[] = { ".c", ".cc", ".cpp", ".cxx", ".m", ".mm" };
+    Nob_String_View sv = nob_sv_from_cstr(path);
+    for (size_t i = 0; i < NOB_ARRAY_LEN(extensions); ++i) {
+        if (nob_sv_end_with(sv, extensions[i])) return true;
     }
-    return proc;
+    return false;
 }
 
-NOBDEF Nob_Fd nob_fd_open_for_read(const char *path)
+// cc, gcc, clang, x86_64-w64-mingw32-gcc, aarch64-linux-android24-clang, clang-17, g++.exe, cl.exe
+static bool nob__is_compiler(const char *program)
 {
-#ifndef _WIN32
-    Nob_Fd result = open(path, O_RDONLY);
-    if (result < 0) {
-        nob_log(NOB_ERROR, "Could not open file %s: %s", path, strerror(errno));
-        return NOB_INVALID_FD;
+    Nob_String_View name = nob_sv_from_cstr(program);
+    for (size_t i = name.count; i > 0; --i) {
+        if (name.data[i - 1] == '/' || name.data[i - 1] == '\\') {
+            name = nob_sv_from_parts(name.data + i, name.count - i);
+            break;
+        }
     }
-    return result;
-#else
-    // https://docs.microsoft.com/en-us/windows/win32/fileio/opening-a-file-for-reading-or-writing
-    SECURITY_ATTRIBUTES saAttr = {0};
-    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
-    saAttr.bInheritHandle = TRUE;
-
-    Nob_Fd result = CreateFile(
-                    path,
-                    GENERIC_READ,
-                    0,
-                    &saAttr,
-                    OPEN_EXISTING,
-                    FILE_ATTRIBUTE_READONLY,
-                    NULL);
-
-    if (result == INVALID_HANDLE_VALUE) {
-        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
-        return NOB_INVALID_FD;
+    if (nob_sv_end_with(name, ".exe")) name.count -= 4;
+    // a version suffix like the one of gcc-13
+    size_t end = name.count;
+    while (end > 0 && isdigit((unsigned char)name.data[end - 1])) end -= 1;
+    if (end < name.count && end > 0 && name.data[end - 1] == '-') name.count = end - 1;
+
+    if (nob_sv_eq(name, nob_sv_from_cstr("cl"))) return true;
+    const char *suffixes[] = { "cc", "clang", "++" };
+    for (size_t i = 0; i < NOB_ARRAY_LEN(suffixes); ++i) {
+        if (nob_sv_end_with(name, suffixes[i])) return true;
     }
+    return false;
+}
 
-    return result;
+static bool nob__path_is_absolute(const char *path)
+{
+#ifdef _WIN32
+    return path[0] == '\\' || path[0] == '/' || (path[0] != '\0' && path[1] == ':');
+#else
+    return path[0] == '/';
 #endif // _WIN32
 }
 
-NOBDEF Nob_Fd nob_fd_open_for_write(const char *path)
+static void nob__compdb_add(Nob_Compdb *compdb, Nob_Compdb_Entry entry)
 {
-#ifndef _WIN32
-    Nob_Fd result = open(path,
-                     O_WRONLY | O_CREAT | O_TRUNC,
-                     S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-    if (result < 0) {
-        nob_log(NOB_ERROR, "could not open file %s: %s", path, strerror(errno));
-        return NOB_INVALID_FD;
+    for (size_t i = 0; i < compdb->count; ++i) {
+        if (strcmp(compdb->items[i].file, entry.file) == 0) {
+            // the latest command wins, like the last build stage of a source
+            free(compdb->items[i].file);
+            free(compdb->items[i].json);
+            compdb->items[i] = entry;
+            return;
+        }
     }
-    return result;
-#else
-    SECURITY_ATTRIBUTES saAttr = {0};
-    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
-    saAttr.bInheritHandle = TRUE;
+    nob_da_append(compdb, entry);
+}
 
-    Nob_Fd result = CreateFile(
-                    path,                            // name of the write
-                    GENERIC_WRITE,                   // open for writing
-                    0,                               // do not share
-                    &saAttr,                         // default security
-                    CREATE_ALWAYS,                   // create always
-                    FILE_ATTRIBUTE_NORMAL,           // normal file
-                    NULL                             // no attr. template
-                );
+NOBDEF void nob_compdb_record(Nob_Cmd cmd)
+{
+    if (!nob_compdb.enabled || cmd.count == 0) return;
 
-    if (result == INVALID_HANDLE_VALUE) {
-        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
-        return NOB_INVALID_FD;
+    bool compiles_only = false;
+    size_t sources = 0;
+    const char *output = NULL;
+    for (size_t i = 1; i < cmd.count; ++i) {
+        const char *arg = cmd.items[i];
+        if (strcmp(arg, "-c") == 0 || strcmp(arg, "-S") == 0) compiles_only = true;
+        // preprocessing only
+        if (strcmp(arg, "-E") == 0) return;
+        if (strcmp(arg, "-o") == 0 && i + 1 < cmd.count) {
+            output = cmd.items[++i];
+            continue;
+        }
+        if (arg[0] != '-' && nob__is_source_file(arg)) sources += 1;
+    }
+    if (sources == 0) return;
+    // tools like wayland-scanner take a source as an argument too, the one that compiles it comes later
+    if (!compiles_only && !nob__is_compiler(cmd.items[0])) return;
+    // the output of a command that links too is the binary, not the object of the source
+    if (!compiles_only) output = NULL;
+
+    size_t mark = nob_temp_save();
+    const char *directory = nob_get_current_dir_temp();
+    if (directory == NULL) {
+        nob_temp_rewind(mark);
+        return;
     }
 
-    return result;
-#endif // _WIN32
+    for (size_t k = 1; k < cmd.count; ++k) {
+        const char *file = cmd.items[k];
+        if (strcmp(file, "-o") == 0) {
+            k += 1;
+            continue;
+        }
+        if (file[0] == '-' || !nob__is_source_file(file)) continue;
+
+        Nob_String_Builder sb = {0};
+        nob_sb_append_cstr(&sb, "{\"directory\":\"");
+        nob__json_escape(&sb, directory);
+        nob_sb_append_cstr(&sb, "\",\"file\":\"");
+        nob__json_escape(&sb, file);
+        if (output != NULL) {
+            nob_sb_append_cstr(&sb, "\",\"output\":\"");
+            nob__json_escape(&sb, output);
+        }
+        nob_sb_append_cstr(&sb, "\",\"arguments\":[");
+        for (size_t i = 0; i < cmd.count; ++i) {
+            if (i > 0) nob_da_append(&sb, ',');
+            nob_da_append(&sb, '"');
+            nob__json_escape(&sb, cmd.items[i]);
+            nob_da_append(&sb, '"');
+        }
+        nob_sb_append_cstr(&sb, "]}");
+        nob_sb_append_null(&sb);
+
+        Nob_Compdb_Entry entry = {
+            .file = strdup(nob__path_is_absolute(file) ? file : nob_temp_sprintf("%s/%s", directory, file)),
+            .json = sb.items,
+        };
+        NOB_ASSERT(entry.file != NULL);
+        nob__compdb_add(&nob_compdb, entry);
+    }
+    nob_temp_rewind(mark);
 }
 
-NOBDEF void nob_fd_close(Nob_Fd fd)
+// Chops a JSON string off sv and appends its value to out unless out is NULL.
+// Escapes other than the simple ones are kept as they are, paths hardly ever have them.
+static bool nob__json_chop_string(Nob_String_View *sv, Nob_String_Builder *out)
 {
-#ifdef _WIN32
-    CloseHandle(fd);
-#else
-    close(fd);
-#endif // _WIN32
+    if (sv->count == 0 || sv->data[0] != '"') return false;
+    nob_sv_chop_left(sv, 1);
+    while (sv->count > 0) {
+        char c = sv->data[0];
+        nob_sv_chop_left(sv, 1);
+        if (c == '"') return true;
+        if (c == '\\' && sv->count > 0) {
+            char e = sv->data[0];
+            nob_sv_chop_left(sv, 1);
+            switch (e) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case '"': case '\\': case '/': c = e; break;
+                default:
+                    if (out) nob_da_append(out, '\\');
+                    c = e;
+            }
+        }
+        if (out) nob_da_append(out, c);
+    }
+    return false;
 }
 
-NOBDEF bool nob_procs_wait(Nob_Procs procs)
+// Chops any JSON value off sv
+static bool nob__json_chop_value(Nob_String_View *sv)
 {
-    bool success = true;
-    for (size_t i = 0; i < procs.count; ++i) {
-        success = nob_proc_wait(procs.items[i]) && success;
+    *sv = nob_sv_trim_left(*sv);
+    if (sv->count == 0) return false;
+    if (sv->data[0] == '"') return nob__json_chop_string(sv, NULL);
+    if (sv->data[0] == '[' || sv->data[0] == '{') {
+        char close = sv->data[0] == '[' ? ']' : '}';
+        nob_sv_chop_left(sv, 1);
+        for (;;) {
+            *sv = nob_sv_trim_left(*sv);
+            if (sv->count == 0) return false;
+            if (sv->data[0] == close) {
+                nob_sv_chop_left(sv, 1);
+                return true;
+            }
+            if (sv->data[0] == ',' || sv->data[0] == ':') {
+                nob_sv_chop_left(sv, 1);
+                continue;
+            }
+            if (!nob__json_chop_value(sv)) return false;
+        }
     }
-    return success;
+    // numbers, true, false, null
+    while (sv->count > 0 && !strchr(",]}: \t\r\n", sv->data[0])) nob_sv_chop_left(sv, 1);
+    return true;
 }
 
-NOBDEF bool nob_procs_wait_and_reset(Nob_Procs *procs)
+// Reads the entries of an existing compilation database into compdb. Entries of sources that do
+// not exist anymore are left out.
+static bool nob__compdb_read(const char *path, Nob_Compdb *compdb)
 {
-    bool success = nob_procs_wait(*procs);
-    procs->count = 0;
-    return success;
+    Nob_String_Builder content = {0};
+    Nob_String_Builder directory = {0};
+    Nob_String_Builder file = {0};
+    bool result = true;
+
+    if (!nob_read_entire_file(path, &content)) nob_return_defer(false);
+    Nob_String_View sv = nob_sv_trim(nob_sb_to_sv(content));
+    if (sv.count == 0 || sv.data[0] != '[') {
+        nob_log(NOB_ERROR, "%s: not a compilation database", path);
+        nob_return_defer(false);
+    }
+    nob_sv_chop_left(&sv, 1);
+
+    for (;;) {
+        sv = nob_sv_trim_left(sv);
+        if (sv.count > 0 && sv.data[0] == ',') {
+            nob_sv_chop_left(&sv, 1);
+            continue;
+        }
+        if (sv.count == 0 || sv.data[0] == ']') break;
+        if (sv.data[0] != '{') {
+            nob_log(NOB_ERROR, "%s: expected an object", path);
+            nob_return_defer(false);
+        }
+
+        const char *start = sv.data;
+        directory.count = 0;
+        file.count = 0;
+        nob_sv_chop_left(&sv, 1);
+        for (;;) {
+            sv = nob_sv_trim_left(sv);
+            if (sv.count > 0 && sv.data[0] == ',') {
+                nob_sv_chop_left(&sv, 1);
+                continue;
+            }
+            if (sv.count > 0 && sv.data[0] == '}') {
+                nob_sv_chop_left(&sv, 1);
+                break;
+            }
+            Nob_String_Builder key = {0};
+            bool ok = nob__json_chop_string(&sv, &key);
+            Nob_String_View key_sv = nob_sb_to_sv(key);
+            sv = nob_sv_trim_left(sv);
+            ok = ok && sv.count > 0 && sv.data[0] == ':';
+            if (ok) {
+                nob_sv_chop_left(&sv, 1);
+                sv = nob_sv_trim_left(sv);
+                if (nob_sv_eq(key_sv, nob_sv_from_cstr("directory"))) {
+                    ok = nob__json_chop_string(&sv, &directory);
+                } else if (nob_sv_eq(key_sv, nob_sv_from_cstr("file"))) {
+                    ok = nob__json_chop_string(&sv, &file);
+                } else {
+                    ok = nob__json_chop_value(&sv);
+                }
+            }
+            nob_sb_free(key);
+            if (!ok) {
+                nob_log(NOB_ERROR, "%s: invalid entry", path);
+                nob_return_defer(false);
+            }
+        }
+
+        if (file.count == 0) continue;
+        nob_sb_append_null(&file);
+        nob_sb_append_null(&directory);
+        const char *file_path = file.items;
+        if (!nob__path_is_absolute(file_path)) file_path = nob_temp_sprintf("%s/%s", directory.items, file.items);
+        if (nob_file_exists(file_path) != 1) continue;
+
+        Nob_Compdb_Entry entry = {
+            .file = strdup(file_path),
+            .json = strdup(nob_temp_sv_to_cstr(nob_sv_from_parts(start, (size_t)(sv.data - start)))),
+        };
+        NOB_ASSERT(entry.file != NULL && entry.json != NULL);
+        nob_da_append(compdb, entry);
+    }
+
+defer:
+    nob_sb_free(content);
+    nob_sb_free(directory);
+    nob_sb_free(file);
+    return result;
 }
 
-NOBDEF bool nob_proc_wait(Nob_Proc proc)
+static void nob__compdb_free(Nob_Compdb *compdb)
 {
-    if (proc == NOB_INVALID_PROC) return false;
+    for (size_t i = 0; i < compdb->count; ++i) {
+        free(compdb->items[i].file);
+        free(compdb->items[i].json);
+    }
+    compdb->count = 0;
+}
 
-#ifdef _WIN32
-    DWORD result = WaitForSingleObject(
-                       proc,    // HANDLE hHandle,
-                       INFINITE // DWORD  dwMilliseconds
-                   );
+NOBDEF bool nob_compdb_write(const char *path, const char **merge_paths, size_t merge_paths_count)
+{
+    bool result = true;
+    Nob_Compdb others = {0};
+    Nob_String_Builder sb = {0};
+    const char *temp_path = nob_temp_sprintf("%s.tmp", path);
 
-    if (result == WAIT_FAILED) {
-        nob_log(NOB_ERROR, "could not wait on child process: %s", nob_win32_error_message(GetLastError()));
-        return false;
+    // the recorded commands come first, then the merged databases and the previous one
+    for (size_t i = 0; i < merge_paths_count; ++i) {
+        if (nob_file_exists(merge_paths[i]) != 1) continue;
+        if (!nob__compdb_read(merge_paths[i], &others)) nob_return_defer(false);
     }
+    if (nob_file_exists(path) == 1 && !nob__compdb_read(path, &others)) nob_return_defer(false);
+
+    nob_sb_append_cstr(&sb, "[\n");
+    size_t written = 0;
+    for (size_t i = 0; i < nob_compdb.count + others.count; ++i) {
+        Nob_Compdb_Entry *entry = i < nob_compdb.count ? &nob_compdb.items[i] : &others.items[i - nob_compdb.count];
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; ++j) {
+            Nob_Compdb_Entry *earlier = j < nob_compdb.count ? &nob_compdb.items[j] : &others.items[j - nob_compdb.count];
+            seen = strcmp(earlier->file, entry->file) == 0;
+        }
+        if (seen) continue;
+        if (written++ > 0) nob_sb_append_cstr(&sb, ",\n");
+        nob_sb_append_cstr(&sb, entry->json);
+    }
+    nob_sb_append_cstr(&sb, "\n]\n");
 
-    DWORD exit_status;
-    if (!GetExitCodeProcess(proc, &exit_status)) {
-        nob_log(NOB_ERROR, "could not get process exit code: %s", nob_win32_error_message(GetLastError()));
-        return false;
+    if (!nob_write_entire_file(temp_path, sb.items, sb.count)) nob_return_defer(false);
+    if (!nob_rename(temp_path, path)) nob_return_defer(false);
+
+defer:
+    nob__compdb_free(&others);
+    nob_da_free(others);
+    nob_sb_free(sb);
+    return result;
+}
+
+NOBDEF void nob_compdb_reset(void)
+{
+    nob__compdb_free(&nob_compdb);
+}
+
+NOBDEF Nob_Proc nob_cmd_run_async_redirect(Nob_Cmd cmd, Nob_Cmd_Redirect redirect)
+{
+    return nob_cmd_start_process(cmd, redirect.fdin, redirect.fdout, redirect.fderr);
+}
+
+NOBDEF Nob_Proc nob_cmd_start_process(Nob_Cmd cmd, Nob_Fd *fdin, Nob_Fd *fdout, Nob_Fd *fderr)
+{
+    if (cmd.count < 1) {
+        nob_log(NOB_ERROR, "Could not run empty command");
+        return NOB_INVALID_PROC;
     }
 
-    if (exit_status != 0) {
-        nob_log(NOB_ERROR, "command exited with exit code %lu", exit_status);
-        return false;
+    // Rendering is only paid for when somebody looks at the result. The buffer is reused between
+    // the launches, there are hundreds of them in a build.
+    static Nob_String_Builder rendered = {0};
+    Nob_Trace_Event event = {0};
+    if (nob_minimal_log_level <= NOB_INFO || nob_trace.enabled) {
+        rendered.count = 0;
+        nob_cmd_render(cmd, &rendered);
+        nob_sb_append_null(&rendered);
+        nob_log(NOB_INFO, "CMD: %s", rendered.items);
+        if (nob_trace.enabled) {
+            event.label = nob__trace_label(cmd);
+            event.command = strdup(rendered.items);
+            NOB_ASSERT(event.command != NULL);
+            event.start_usec = nob_time_usec();
+        }
     }
+    nob_compdb_record(cmd);
 
-    CloseHandle(proc);
+#ifdef _WIN32
+    // https://docs.microsoft.com/en-us/windows/win32/procthread/creating-a-child-process-with-redirected-input-and-output
 
-    return true;
-#else
-    for (;;) {
-        int wstatus = 0;
-        if (waitpid(proc, &wstatus, 0) < 0) {
-            nob_log(NOB_ERROR, "could not wait on command (pid %d): %s", proc, strerror(errno));
-            return false;
-        }
+    STARTUPINFO siStartInfo;
+    ZeroMemory(&siStartInfo, sizeof(siStartInfo));
+    siStartInfo.cb = sizeof(STARTUPINFO);
+    // NOTE: theoretically setting NULL to std handles should not be a problem
+    // https://docs.microsoft.com/en-us/windows/console/getstdhandle?redirectedfrom=MSDN#attachdetach-behavior
+    // TODO: check for errors in GetStdHandle
+    siStartInfo.hStdError = fderr ? *fderr : GetStdHandle(STD_ERROR_HANDLE);
+    siStartInfo.hStdOutput = fdout ? *fdout : GetStdHandle(STD_OUTPUT_HANDLE);
+    siStartInfo.hStdInput = fdin ? *fdin : GetStdHandle(STD_INPUT_HANDLE);
+    siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
 
-        if (WIFEXITED(wstatus)) {
-            int exit_status = WEXITSTATUS(wstatus);
-            if (exit_status != 0) {
-                nob_log(NOB_ERROR, "command exited with exit code %d", exit_status);
-                return false;
-            }
+    PROCESS_INFORMATION piProcInfo;
+    ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
 
-            break;
-        }
+    Nob_String_Builder sb = {0};
+    nob__win32_cmd_quote(cmd, &sb);
+    nob_sb_append_null(&sb);
+    BOOL bSuccess = CreateProcessA(NULL, sb.items, NULL, NULL, TRUE, 0, NULL, NULL, &siStartInfo, &piProcInfo);
+    nob_sb_free(sb);
 
-        if (WIFSIGNALED(wstatus)) {
-            nob_log(NOB_ERROR, "command process was terminated by signal %d", WTERMSIG(wstatus));
-            return false;
-        }
+    if (!bSuccess) {
+        nob_log(NOB_ERROR, "Could not create child process for %s: %s", cmd.items[0], nob_win32_error_message(GetLastError()));
+        return NOB_INVALID_PROC;
     }
 
-    return true;
-#endif
-}
+    CloseHandle(piProcInfo.hThread);
 
-NOBDEF bool nob_procs_append_with_flush(Nob_Procs *procs, Nob_Proc proc, size_t max_procs_count)
-{
-    nob_da_append(procs, proc);
+    if (nob_trace.enabled) {
+        event.pid = GetProcessId(piProcInfo.hProcess);
+        nob_da_append(&nob_trace, event);
+    }
 
-    if (procs->count >= max_procs_count) {
-        if (!nob_procs_wait_and_reset(procs)) return false;
+    return piProcInfo.hProcess;
+#else
+    // posix_spawn() does not copy the page tables of nob like fork() does, glibc and macOS start
+    // the child with vfork semantics. The redirects are done by the file actions in the child.
+    posix_spawn_file_actions_t actions;
+    int err = posix_spawn_file_actions_init(&actions);
+    if (err != 0) {
+        nob_log(NOB_ERROR, "Could not create the spawn file actions: %s", strerror(err));
+        return NOB_INVALID_PROC;
+    }
+    if (err == 0 && fdin)  err = posix_spawn_file_actions_adddup2(&actions, *fdin, STDIN_FILENO);
+    if (err == 0 && fdout) err = posix_spawn_file_actions_adddup2(&actions, *fdout, STDOUT_FILENO);
+    if (err == 0 && fderr) err = posix_spawn_file_actions_adddup2(&actions, *fderr, STDERR_FILENO);
+    if (err != 0) {
+        nob_log(NOB_ERROR, "Could not setup the redirects for child process: %s", strerror(err));
+        posix_spawn_file_actions_destroy(&actions);
+        return NOB_INVALID_PROC;
     }
 
-    return true;
-}
+    static Nob_Cmd cmd_null = {0};
+    cmd_null.count = 0;
+    nob_da_append_many(&cmd_null, cmd.items, cmd.count);
+    nob_cmd_append(&cmd_null, NULL);
+
+    pid_t cpid;
+    err = posix_spawnp(&cpid, cmd.items[0], &actions, NULL, (char * const*) cmd_null.items, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0) {
+        nob_log(NOB_ERROR, "Could not exec child process for %s: %s", cmd.items[0], strerror(err));
+        if (nob_trace.enabled) {
+            free(event.label);
+            free(event.command);
+        }
+        return NOB_INVALID_PROC;
+    }
 
-NOBDEF bool nob_cmd_run_sync_redirect(Nob_Cmd cmd, Nob_Cmd_Redirect redirect)
-{
-    Nob_Proc p = nob_cmd_start_process(cmd, redirect.fdin, redirect.fdout, redirect.fderr);
-    return nob_proc_wait(p);
+    if (nob_trace.enabled) {
+        event.pid = cpid;
+        nob_da_append(&nob_trace, event);
+    }
+
+    return cpid;
+#endif
 }
 
-NOBDEF bool nob_cmd_run_sync(Nob_Cmd cmd)
+NOBDEF Nob_Proc nob_cmd_run_async(Nob_Cmd cmd)
 {
-    Nob_Proc p = nob_cmd_start_process(cmd, NULL, NULL, NULL);
-    return nob_proc_wait(p);
+    return nob_cmd_start_process(cmd, NULL, NULL, NULL);
 }
 
-NOBDEF bool nob_cmd_run_sync_and_reset(Nob_Cmd *cmd)
+NOBDEF Nob_Proc nob_cmd_run_async_and_reset(Nob_Cmd *cmd)
 {
-    Nob_Proc p = nob_cmd_start_process(*cmd, NULL, NULL, NULL);
+    Nob_Proc proc = nob_cmd_start_process(*cmd, NULL, NULL, NULL);
     cmd->count = 0;
-    return nob_proc_wait(p);
+    return proc;
 }
 
-NOBDEF bool nob_cmd_run_sync_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect)
+NOBDEF Nob_Proc nob_cmd_run_async_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect)
 {
-    Nob_Proc p = nob_cmd_start_process(*cmd, redirect.fdin, redirect.fdout, redirect.fderr);
+    Nob_Proc proc = nob_cmd_start_process(*cmd, redirect.fdin, redirect.fdout, redirect.fderr);
     cmd->count = 0;
     if (redirect.fdin) {
         nob_fd_close(*redirect.fdin);
@@ -1302,41 +2118,701 @@ NOBDEF bool nob_cmd_run_sync_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect r
         nob_fd_close(*redirect.fderr);
         *redirect.fderr = NOB_INVALID_FD;
     }
-    return nob_proc_wait(p);
+    return proc;
 }
 
-NOBDEF void nob_log(Nob_Log_Level level, const char *fmt, ...)
+NOBDEF Nob_Fd nob_fd_open_for_read(const char *path)
 {
-    if (level < nob_minimal_log_level) return;
+#ifndef _WIN32
+    Nob_Fd result = open(path, O_RDONLY);
+    if (result < 0) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, strerror(errno));
+        return NOB_INVALID_FD;
+    }
+    return result;
+#else
+    // https://docs.microsoft.com/en-us/windows/win32/fileio/opening-a-file-for-reading-or-writing
+    SECURITY_ATTRIBUTES saAttr = {0};
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
 
-    switch (level) {
-    case NOB_INFO:
-        fprintf(stderr, "[INFO] ");
-        break;
-    case NOB_WARNING:
-        fprintf(stderr, "[WARNING] ");
-        break;
-    case NOB_ERROR:
-        fprintf(stderr, "[ERROR] ");
-        break;
-    case NOB_NO_LOGS: return;
-    default:
-        NOB_UNREACHABLE("nob_log");
+    Nob_Fd result = CreateFile(
+                    path,
+                    GENERIC_READ,
+                    0,
+                    &saAttr,
+                    OPEN_EXISTING,
+                    FILE_ATTRIBUTE_READONLY,
+                    NULL);
+
+    if (result == INVALID_HANDLE_VALUE) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return NOB_INVALID_FD;
     }
 
-    va_list args;
-    va_start(args, fmt);
-    vfprintf(stderr, fmt, args);
-    va_end(args);
-    fprintf(stderr, "\n");
+    return result;
+#endif // _WIN32
 }
 
-NOBDEF bool nob_read_entire_dir(const char *parent, Nob_File_Paths *children)
+NOBDEF Nob_Fd nob_fd_open_for_write(const char *path)
 {
-    bool result = true;
-    DIR *dir = NULL;
-    struct dirent *ent = NULL;
-
+#ifndef _WIN32
+    Nob_Fd result = open(path,
+                     O_WRONLY | O_CREAT | O_TRUNC,
+                     S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (result < 0) {
+        nob_log(NOB_ERROR, "could not open file %s: %s", path, strerror(errno));
+        return NOB_INVALID_FD;
+    }
+    return result;
+#else
+    SECURITY_ATTRIBUTES saAttr = {0};
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+
+    Nob_Fd result = CreateFile(
+                    path,                            // name of the write
+                    GENERIC_WRITE,                   // open for writing
+                    0,                               // do not share
+                    &saAttr,                         // default security
+                    CREATE_ALWAYS,                   // create always
+                    FILE_ATTRIBUTE_NORMAL,           // normal file
+                    NULL                             // no attr. template
+                );
+
+    if (result == INVALID_HANDLE_VALUE) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return NOB_INVALID_FD;
+    }
+
+    return result;
+#endif // _WIN32
+}
+
+NOBDEF void nob_fd_close(Nob_Fd fd)
+{
+#ifdef _WIN32
+    CloseHandle(fd);
+#else
+    close(fd);
+#endif // _WIN32
+}
+
+typedef struct {
+    bool active;
+    Nob_String_Builder tokens; // the slots nob took, they have to be given back as they were read
+#ifdef _WIN32
+    HANDLE semaphore;
+#else
+    int read_fd;               // a nonblocking end of nob's own, when possible
+    int write_fd;
+#endif // _WIN32
+} Nob__Jobserver;
+
+static Nob__Jobserver nob__jobserver = {0};
+
+static void nob__jobserver_release(void)
+{
+    NOB_ASSERT(nob__jobserver.tokens.count > 0);
+    char token = nob__jobserver.tokens.items[--nob__jobserver.tokens.count];
+#ifdef _WIN32
+    NOB_UNUSED(token);
+    if (!ReleaseSemaphore(nob__jobserver.semaphore, 1, NULL)) {
+        nob_log(NOB_ERROR, "could not give back a jobserver slot: %s", nob_win32_error_message(GetLastError()));
+    }
+#else
+    while (write(nob__jobserver.write_fd, &token, 1) < 0) {
+        if (errno == EINTR) continue;
+        nob_log(NOB_ERROR, "could not give back a jobserver slot: %s", strerror(errno));
+        break;
+    }
+#endif // _WIN32
+}
+
+// Tries to take one more slot for up to timeout_ms milliseconds
+static bool nob__jobserver_take(int timeout_ms)
+{
+#ifdef _WIN32
+    DWORD result = WaitForSingleObject(nob__jobserver.semaphore, (DWORD)timeout_ms);
+    if (result != WAIT_OBJECT_0) return false;
+    nob_da_append(&nob__jobserver.tokens, '+');
+    return true;
+#else
+    // another client may take the token between poll() and read(), which only blocks when nob
+    // could not get a nonblocking end of its own
+    struct pollfd pfd = { .fd = nob__jobserver.read_fd, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+    char token;
+    if (read(nob__jobserver.read_fd, &token, 1) != 1) return false;
+    nob_da_append(&nob__jobserver.tokens, token);
+    return true;
+#endif // _WIN32
+}
+
+// Every running process but the first needs a slot
+static void nob__jobserver_release_unused(size_t running)
+{
+    while (nob__jobserver.tokens.count > 0 && nob__jobserver.tokens.count + 1 > running) {
+        nob__jobserver_release();
+    }
+}
+
+#ifndef _WIN32
+// Opens a nonblocking read end of nob's own, since making the shared one nonblocking would affect
+// every other client of the jobserver. Falls back to the shared one where that is not possible.
+static int nob__jobserver_open_read_end(int fd)
+{
+    int own = open(nob_temp_sprintf("/proc/self/fd/%d", fd), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    return own < 0 ? fd : own;
+}
+#endif // _WIN32
+
+static bool nob__jobserver_join(const char *makeflags)
+{
+    const char *auth = NULL;
+    const char *options[] = { "--jobserver-auth=", "--jobserver-fds=" };
+    for (size_t i = 0; i < NOB_ARRAY_LEN(options); ++i) {
+        // the last one wins, like in make
+        for (const char *p = strstr(makeflags, options[i]); p != NULL; p = strstr(p + 1, options[i])) {
+            auth = p + strlen(options[i]);
+        }
+        if (auth != NULL) break;
+    }
+    if (auth == NULL) return false;
+
+    Nob_String_View value = nob_sv_from_cstr(auth);
+    value = nob_sv_chop_by_delim(&value, ' ');
+    const char *value_cstr = nob_temp_sv_to_cstr(value);
+
+#ifdef _WIN32
+    HANDLE semaphore = OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, FALSE, value_cstr);
+    if (semaphore == NULL) {
+        nob_log(NOB_WARNING, "could not open the jobserver semaphore %s: %s", value_cstr, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    nob__jobserver.semaphore = semaphore;
+#else
+    if (strncmp(value_cstr, "fifo:", 5) == 0) {
+        const char *fifo = value_cstr + 5;
+        int read_fd = open(fifo, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        int write_fd = open(fifo, O_WRONLY | O_CLOEXEC);
+        if (read_fd < 0 || write_fd < 0) {
+            nob_log(NOB_WARNING, "could not open the jobserver fifo %s: %s", fifo, strerror(errno));
+            if (read_fd >= 0) close(read_fd);
+            if (write_fd >= 0) close(write_fd);
+            return false;
+        }
+        nob__jobserver.read_fd = read_fd;
+        nob__jobserver.write_fd = write_fd;
+    } else {
+        int read_fd, write_fd;
+        if (sscanf(value_cstr, "%d,%d", &read_fd, &write_fd) != 2) {
+            nob_log(NOB_WARNING, "could not parse the jobserver %s", value_cstr);
+            return false;
+        }
+        // make closes the pipe for commands it does not consider recursive
+        if (fcntl(read_fd, F_GETFD) < 0 || fcntl(write_fd, F_GETFD) < 0) {
+            nob_log(NOB_WARNING, "the jobserver pipe %s is not available, prefix the command running nob with + in the Makefile", value_cstr);
+            return false;
+        }
+        nob__jobserver.read_fd = nob__jobserver_open_read_end(read_fd);
+        nob__jobserver.write_fd = write_fd;
+    }
+#endif // _WIN32
+
+    nob_log(NOB_INFO, "Using the jobserver %s", value_cstr);
+    return true;
+}
+
+static bool nob__jobserver_serve(size_t jobs)
+{
+    const char *makeflags = getenv("MAKEFLAGS");
+    if (makeflags == NULL) makeflags = "";
+
+#ifdef _WIN32
+    const char *name = nob_temp_sprintf("gmake_semaphore_nob_%lu", GetCurrentProcessId());
+    LONG slots = jobs > 1 ? (LONG)jobs - 1 : 0;
+    HANDLE semaphore = CreateSemaphoreA(NULL, slots, slots > 0 ? slots : 1, name);
+    if (semaphore == NULL) {
+        nob_log(NOB_ERROR, "could not create the jobserver semaphore: %s", nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    nob__jobserver.semaphore = semaphore;
+    if (!SetEnvironmentVariableA("MAKEFLAGS", nob_temp_sprintf("%s -j%zu --jobserver-auth=%s", makeflags, jobs, name))) {
+        nob_log(NOB_ERROR, "could not set MAKEFLAGS: %s", nob_win32_error_message(GetLastError()));
+        return false;
+    }
+#else
+    // the pipe is inherited by every child, that is how they find the slots
+    int fds[2];
+    if (pipe(fds) < 0) {
+        nob_log(NOB_ERROR, "could not create the jobserver pipe: %s", strerror(errno));
+        return false;
+    }
+    for (size_t i = 1; i < jobs; ++i) {
+        char token = '+';
+        if (write(fds[1], &token, 1) != 1) {
+            nob_log(NOB_ERROR, "could not fill the jobserver pipe: %s", strerror(errno));
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+    }
+    nob__jobserver.read_fd = nob__jobserver_open_read_end(fds[0]);
+    nob__jobserver.write_fd = fds[1];
+    const char *auth = nob_temp_sprintf("%d,%d", fds[0], fds[1]);
+    if (setenv("MAKEFLAGS", nob_temp_sprintf("%s -j%zu --jobserver-auth=%s", makeflags, jobs, auth), 1) < 0) {
+        nob_log(NOB_ERROR, "could not set MAKEFLAGS: %s", strerror(errno));
+        return false;
+    }
+#endif // _WIN32
+
+    return true;
+}
+
+NOBDEF bool nob_jobserver_init(size_t jobs)
+{
+    if (nob__jobserver.active) return true;
+    const char *makeflags = getenv("MAKEFLAGS");
+    if (makeflags == NULL || !nob__jobserver_join(makeflags)) {
+        if (!nob__jobserver_serve(jobs)) return false;
+    }
+    nob__jobserver.active = true;
+    return true;
+}
+
+NOBDEF bool nob_jobserver_active(void)
+{
+    return nob__jobserver.active;
+}
+
+NOBDEF bool nob_procs_wait(Nob_Procs procs)
+{
+    bool success = true;
+    for (size_t i = 0; i < procs.count; ++i) {
+        success = nob_proc_wait(procs.items[i]) && success;
+    }
+    if (nob__jobserver.active) nob__jobserver_release_unused(0);
+    return success;
+}
+
+// Index of a process of procs that has finished but was not collected yet, or -1 if there is none.
+// With block it waits until there is one.
+static long nob__procs_find_finished(Nob_Procs procs, bool block)
+{
+    if (procs.count == 0) return -1;
+
+#ifdef _WIN32
+    DWORD count = procs.count < MAXIMUM_WAIT_OBJECTS ? (DWORD)procs.count : MAXIMUM_WAIT_OBJECTS;
+    DWORD result = WaitForMultipleObjects(count, procs.items, FALSE, block ? INFINITE : 0);
+    if (result == WAIT_TIMEOUT) return -1;
+    if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + count) return (long)(result - WAIT_OBJECT_0);
+    // let nob_proc_wait() report what is wrong with the first one
+    return 0;
+#else
+    // WNOWAIT leaves the child to nob_proc_wait(), and children that were started outside of
+    // procs are not collected behind their owner's back the way waitpid(-1) would
+    if (block) {
+        siginfo_t info = {0};
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == 0) {
+            for (size_t i = 0; i < procs.count; ++i) {
+                if (procs.items[i] == info.si_pid) return (long)i;
+            }
+        }
+        // a child that is not in procs finished, it stays unwaited so look at procs one by one
+    }
+    for (;;) {
+        for (size_t i = 0; i < procs.count; ++i) {
+            siginfo_t info = {0};
+            if (waitid(P_PID, procs.items[i], &info, WEXITED | WNOHANG | WNOWAIT) < 0) return (long)i;
+            if (info.si_pid != 0) return (long)i;
+        }
+        if (!block) return -1;
+        poll(NULL, 0, 10);
+    }
+#endif // _WIN32
+}
+
+static bool nob__procs_collect(Nob_Procs *procs, size_t index, Nob_Proc *finished)
+{
+    Nob_Proc proc = procs->items[index];
+    procs->items[index] = procs->items[--procs->count];
+    bool success = nob_proc_wait(proc);
+    if (nob__jobserver.active) nob__jobserver_release_unused(procs->count);
+    if (finished) *finished = proc;
+    return success;
+}
+
+NOBDEF bool nob_procs_wait_any(Nob_Procs *procs, Nob_Proc *finished)
+{
+    NOB_ASSERT(procs->count > 0);
+    long index = nob__procs_find_finished(*procs, true);
+    return nob__procs_collect(procs, index < 0 ? 0 : (size_t)index, finished);
+}
+
+NOBDEF bool nob_procs_wait_for_slot(Nob_Procs *procs, size_t max_procs_count)
+{
+    bool success = true;
+    while (procs->count > 0 && procs->count >= max_procs_count) {
+        success = nob_procs_wait_any(procs, NULL) && success;
+    }
+    if (!nob__jobserver.active) return success;
+
+    // the slot of a process that finishes goes back to the jobserver, so nob keeps looking for
+    // finished processes while it waits, otherwise it could wait on a slot it holds itself
+    while (nob__jobserver.tokens.count < procs->count) {
+        long index = nob__procs_find_finished(*procs, false);
+        if (index >= 0) {
+            success = nob__procs_collect(procs, (size_t)index, NULL) && success;
+            continue;
+        }
+        nob__jobserver_take(10);
+    }
+    return success;
+}
+
+NOBDEF bool nob_procs_wait_and_reset(Nob_Procs *procs)
+{
+    bool success = nob_procs_wait(*procs);
+    procs->count = 0;
+    return success;
+}
+
+static bool nob__proc_wait(Nob_Proc proc);
+
+NOBDEF bool nob_proc_wait(Nob_Proc proc)
+{
+    if (proc == NOB_INVALID_PROC) return false;
+    if (!nob_trace.enabled) return nob__proc_wait(proc);
+
+#ifdef _WIN32
+    long long pid = GetProcessId(proc);
+#else
+    long long pid = proc;
+#endif
+    bool result = nob__proc_wait(proc);
+    // pids get reused, the process is the latest one with this pid that did not finish yet
+    for (size_t i = nob_trace.count; i > 0; --i) {
+        Nob_Trace_Event *event = &nob_trace.items[i - 1];
+        if (event->pid == pid && event->end_usec == 0) {
+            event->end_usec = nob_time_usec();
+            event->failed = !result;
+            break;
+        }
+    }
+    return result;
+}
+
+static bool nob__proc_wait(Nob_Proc proc)
+{
+#ifdef _WIN32
+    DWORD result = WaitForSingleObject(
+                       proc,    // HANDLE hHandle,
+                       INFINITE // DWORD  dwMilliseconds
+                   );
+
+    if (result == WAIT_FAILED) {
+        nob_log(NOB_ERROR, "could not wait on child process: %s", nob_win32_error_message(GetLastError()));
+        return false;
+    }
+
+    DWORD exit_status;
+    if (!GetExitCodeProcess(proc, &exit_status)) {
+        nob_log(NOB_ERROR, "could not get process exit code: %s", nob_win32_error_message(GetLastError()));
+        return false;
+    }
+
+    if (exit_status != 0) {
+        nob_log(NOB_ERROR, "command exited with exit code %lu", exit_status);
+        return false;
+    }
+
+    CloseHandle(proc);
+
+    return true;
+#else
+    for (;;) {
+        int wstatus = 0;
+        if (waitpid(proc, &wstatus, 0) < 0) {
+            nob_log(NOB_ERROR, "could not wait on command (pid %d): %s", proc, strerror(errno));
+            return false;
+        }
+
+        if (WIFEXITED(wstatus)) {
+            int exit_status = WEXITSTATUS(wstatus);
+            if (exit_status != 0) {
+                nob_log(NOB_ERROR, "command exited with exit code %d", exit_status);
+                return false;
+            }
+
+            break;
+        }
+
+        if (WIFSIGNALED(wstatus)) {
+            nob_log(NOB_ERROR, "command process was terminated by signal %d", WTERMSIG(wstatus));
+            return false;
+        }
+    }
+
+    return true;
+#endif
+}
+
+NOBDEF bool nob_procs_append_with_flush(Nob_Procs *procs, Nob_Proc proc, size_t max_procs_count)
+{
+    if (proc == NOB_INVALID_PROC) return false;
+    nob_da_append(procs, proc);
+    return nob_procs_wait_for_slot(procs, max_procs_count);
+}
+
+// Creates a pipe whose ends are not inherited by the children, except for the end that a child gets
+// as its stdout or stderr
+static bool nob__capture_pipe(Nob_Fd *read_end, Nob_Fd *write_end)
+{
+#ifdef _WIN32
+    // NOTE: the write end has to be inheritable, so children started while the capture is running
+    // hold it open as well and the capture only ends once they exit too
+    SECURITY_ATTRIBUTES saAttr = {0};
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+    if (!CreatePipe(read_end, write_end, &saAttr, 0)) {
+        nob_log(NOB_ERROR, "Could not create pipe: %s", nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    if (!SetHandleInformation(*read_end, HANDLE_FLAG_INHERIT, 0)) {
+        nob_log(NOB_ERROR, "Could not setup pipe: %s", nob_win32_error_message(GetLastError()));
+        CloseHandle(*read_end);
+        CloseHandle(*write_end);
+        return false;
+    }
+#else
+    int fds[2];
+    if (pipe(fds) < 0) {
+        nob_log(NOB_ERROR, "Could not create pipe: %s", strerror(errno));
+        return false;
+    }
+    // the child's copy made by dup2() does not have FD_CLOEXEC, so only the child keeps the write
+    // end open, otherwise the read end never sees the end of the output
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    *read_end = fds[0];
+    *write_end = fds[1];
+#endif // _WIN32
+    return true;
+}
+
+NOBDEF bool nob_capture_start(Nob_Cmd *cmd, bool capture_stderr, Nob_Capture *capture)
+{
+    Nob_Fd out_write = NOB_INVALID_FD;
+    Nob_Fd err_write = NOB_INVALID_FD;
+    capture->proc = NOB_INVALID_PROC;
+    capture->out_pipe = NOB_INVALID_FD;
+    capture->err_pipe = NOB_INVALID_FD;
+    bool result = true;
+
+    if (!nob__capture_pipe(&capture->out_pipe, &out_write)) nob_return_defer(false);
+    if (capture_stderr && !nob__capture_pipe(&capture->err_pipe, &err_write)) nob_return_defer(false);
+
+    capture->proc = nob_cmd_start_process(*cmd, NULL, &out_write, capture_stderr ? &err_write : NULL);
+    if (capture->proc == NOB_INVALID_PROC) nob_return_defer(false);
+
+defer:
+    cmd->count = 0;
+    if (out_write != NOB_INVALID_FD) nob_fd_close(out_write);
+    if (err_write != NOB_INVALID_FD) nob_fd_close(err_write);
+    if (!result) {
+        if (capture->out_pipe != NOB_INVALID_FD) nob_fd_close(capture->out_pipe);
+        if (capture->err_pipe != NOB_INVALID_FD) nob_fd_close(capture->err_pipe);
+        capture->out_pipe = NOB_INVALID_FD;
+        capture->err_pipe = NOB_INVALID_FD;
+    }
+    return result;
+}
+
+// Reads what is available in the pipe into sb. Returns false once the pipe is closed.
+static bool nob__capture_read(Nob_Fd *pipe_end, Nob_String_Builder *sb)
+{
+    nob_da_reserve(sb, sb->count + 4096);
+#ifdef _WIN32
+    DWORD n = 0;
+    if (!ReadFile(*pipe_end, sb->items + sb->count, (DWORD)(sb->capacity - sb->count), &n, NULL) || n == 0) {
+        CloseHandle(*pipe_end);
+        *pipe_end = NOB_INVALID_FD;
+        return false;
+    }
+#else
+    ssize_t n = read(*pipe_end, sb->items + sb->count, sb->capacity - sb->count);
+    if (n < 0 && errno == EINTR) return true;
+    if (n <= 0) {
+        close(*pipe_end);
+        *pipe_end = NOB_INVALID_FD;
+        return false;
+    }
+#endif // _WIN32
+    sb->count += (size_t)n;
+    return true;
+}
+
+NOBDEF bool nob_captures_wait(Nob_Capture *captures, size_t count)
+{
+    bool success = true;
+#ifdef _WIN32
+    // anonymous pipes can't be waited on together, so the ones with data are picked by peeking
+    for (;;) {
+        bool open = false;
+        bool progress = false;
+        for (size_t i = 0; i < count; ++i) {
+            Nob_Fd *pipes[] = { &captures[i].out_pipe, &captures[i].err_pipe };
+            Nob_String_Builder *sbs[] = { &captures[i].out, &captures[i].err };
+            for (size_t j = 0; j < NOB_ARRAY_LEN(pipes); ++j) {
+                if (*pipes[j] == NOB_INVALID_FD) continue;
+                DWORD available = 0;
+                if (!PeekNamedPipe(*pipes[j], NULL, 0, NULL, &available, NULL) || available > 0) {
+                    // a broken pipe makes the read report the end of the output
+                    nob__capture_read(pipes[j], sbs[j]);
+                    progress = true;
+                }
+                if (*pipes[j] != NOB_INVALID_FD) open = true;
+            }
+        }
+        if (!open) break;
+        if (!progress) Sleep(1);
+    }
+#else
+    struct pollfd *pfds = malloc((2*count + 1) * sizeof(*pfds));
+    Nob_Fd **ends = malloc((2*count + 1) * sizeof(*ends));
+    Nob_String_Builder **sbs = malloc((2*count + 1) * sizeof(*sbs));
+    NOB_ASSERT(pfds != NULL && ends != NULL && sbs != NULL);
+    for (;;) {
+        size_t n = 0;
+        for (size_t i = 0; i < count; ++i) {
+            Nob_Fd *pipes[] = { &captures[i].out_pipe, &captures[i].err_pipe };
+            Nob_String_Builder *outputs[] = { &captures[i].out, &captures[i].err };
+            for (size_t j = 0; j < NOB_ARRAY_LEN(pipes); ++j) {
+                if (*pipes[j] == NOB_INVALID_FD) continue;
+                pfds[n] = (struct pollfd) { .fd = *pipes[j], .events = POLLIN };
+                ends[n] = pipes[j];
+                sbs[n++] = outputs[j];
+            }
+        }
+        if (n == 0) break;
+
+        if (poll(pfds, n, -1) < 0) {
+            if (errno == EINTR) continue;
+            nob_log(NOB_ERROR, "Could not wait on the output of the commands: %s", strerror(errno));
+            success = false;
+            break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (pfds[i].revents != 0) nob__capture_read(ends[i], sbs[i]);
+        }
+    }
+    free(pfds);
+    free(ends);
+    free(sbs);
+#endif // _WIN32
+
+    for (size_t i = 0; i < count; ++i) {
+        // the pipes are closed in case reading them failed
+        if (captures[i].out_pipe != NOB_INVALID_FD) nob_fd_close(captures[i].out_pipe);
+        if (captures[i].err_pipe != NOB_INVALID_FD) nob_fd_close(captures[i].err_pipe);
+        captures[i].out_pipe = NOB_INVALID_FD;
+        captures[i].err_pipe = NOB_INVALID_FD;
+        if (captures[i].proc == NOB_INVALID_PROC) continue;
+        success = nob_proc_wait(captures[i].proc) && success;
+        captures[i].proc = NOB_INVALID_PROC;
+    }
+    return success;
+}
+
+NOBDEF bool nob_cmd_run_capture(Nob_Cmd *cmd, Nob_String_Builder *out, Nob_String_Builder *err)
+{
+    Nob_Capture capture = { .out = *out };
+    if (err != NULL) capture.err = *err;
+    bool result = nob_capture_start(cmd, err != NULL, &capture) && nob_captures_wait(&capture, 1);
+    *out = capture.out;
+    if (err != NULL) *err = capture.err;
+    return result;
+}
+
+NOBDEF void nob_capture_free(Nob_Capture *capture)
+{
+    nob_sb_free(capture->out);
+    nob_sb_free(capture->err);
+    memset(&capture->out, 0, sizeof(capture->out));
+    memset(&capture->err, 0, sizeof(capture->err));
+}
+
+NOBDEF bool nob_cmd_run_sync_redirect(Nob_Cmd cmd, Nob_Cmd_Redirect redirect)
+{
+    Nob_Proc p = nob_cmd_start_process(cmd, redirect.fdin, redirect.fdout, redirect.fderr);
+    return nob_proc_wait(p);
+}
+
+NOBDEF bool nob_cmd_run_sync(Nob_Cmd cmd)
+{
+    Nob_Proc p = nob_cmd_start_process(cmd, NULL, NULL, NULL);
+    return nob_proc_wait(p);
+}
+
+NOBDEF bool nob_cmd_run_sync_and_reset(Nob_Cmd *cmd)
+{
+    Nob_Proc p = nob_cmd_start_process(*cmd, NULL, NULL, NULL);
+    cmd->count = 0;
+    return nob_proc_wait(p);
+}
+
+NOBDEF bool nob_cmd_run_sync_redirect_and_reset(Nob_Cmd *cmd, Nob_Cmd_Redirect redirect)
+{
+    Nob_Proc p = nob_cmd_start_process(*cmd, redirect.fdin, redirect.fdout, redirect.fderr);
+    cmd->count = 0;
+    if (redirect.fdin) {
+        nob_fd_close(*redirect.fdin);
+        *redirect.fdin = NOB_INVALID_FD;
+    }
+    if (redirect.fdout) {
+        nob_fd_close(*redirect.fdout);
+        *redirect.fdout = NOB_INVALID_FD;
+    }
+    if (redirect.fderr) {
+        nob_fd_close(*redirect.fderr);
+        *redirect.fderr = NOB_INVALID_FD;
+    }
+    return nob_proc_wait(p);
+}
+
+NOBDEF void nob_log(Nob_Log_Level level, const char *fmt, ...)
+{
+    if (level < nob_minimal_log_level) return;
+
+    switch (level) {
+    case NOB_INFO:
+        fprintf(stderr, "[INFO] ");
+        break;
+    case NOB_WARNING:
+        fprintf(stderr, "[WARNING] ");
+        break;
+    case NOB_ERROR:
+        fprintf(stderr, "[ERROR] ");
+        break;
+    case NOB_NO_LOGS: return;
+    default:
+        NOB_UNREACHABLE("nob_log");
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
+NOBDEF bool nob_read_entire_dir(const char *parent, Nob_File_Paths *children)
+{
+    bool result = true;
+    DIR *dir = NULL;
+    struct dirent *ent = NULL;
+
     dir = opendir(parent);
     if (dir == NULL) {
         #ifdef _WIN32
@@ -1347,301 +2823,1625 @@ NOBDEF bool nob_read_entire_dir(const char *parent, Nob_File_Paths *children)
         nob_return_defer(false);
     }
 
-    errno = 0;
-    ent = readdir(dir);
-    while (ent != NULL) {
-        nob_da_append(children, nob_temp_strdup(ent->d_name));
-        ent = readdir(dir);
+    errno = 0;
+    ent = readdir(dir);
+    while (ent != NULL) {
+        nob_da_append(children, nob_temp_strdup(ent->d_name));
+        ent = readdir(dir);
+    }
+
+    if (errno != 0) {
+        #ifdef _WIN32
+        nob_log(NOB_ERROR, "Could not read directory %s: %s", parent, nob_win32_error_message(GetLastError()));
+        #else
+        nob_log(NOB_ERROR, "Could not read directory %s: %s", parent, strerror(errno));
+        #endif // _WIN32
+        nob_return_defer(false);
+    }
+
+defer:
+    if (dir) closedir(dir);
+    return result;
+}
+
+NOBDEF bool nob_write_entire_file(const char *path, const void *data, size_t size)
+{
+    bool result = true;
+
+    nob_stat_cache_forget(path);
+
+    const char *buf = NULL;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        nob_log(NOB_ERROR, "Could not open file %s for writing: %s\n", path, strerror(errno));
+        nob_return_defer(false);
+    }
+
+    //           len
+    //           v
+    // aaaaaaaaaa
+    //     ^
+    //     data
+
+    buf = (const char*)data;
+    while (size > 0) {
+        size_t n = fwrite(buf, 1, size, f);
+        if (ferror(f)) {
+            nob_log(NOB_ERROR, "Could not write into file %s: %s\n", path, strerror(errno));
+            nob_return_defer(false);
+        }
+        size -= n;
+        buf  += n;
+    }
+
+defer:
+    if (f) fclose(f);
+    return result;
+}
+
+NOBDEF Nob_File_Type nob_get_file_type(const char *path)
+{
+#ifdef _WIN32
+    DWORD attr = GetFileAttributesA(path);
+    if (attr == INVALID_FILE_ATTRIBUTES) {
+        nob_log(NOB_ERROR, "Could not get file attributes of %s: %s", path, nob_win32_error_message(GetLastError()));
+        return -1;
+    }
+
+    if (attr & FILE_ATTRIBUTE_DIRECTORY) return NOB_FILE_DIRECTORY;
+    // TODO: detect symlinks on Windows (whatever that means on Windows anyway)
+    return NOB_FILE_REGULAR;
+#else // _WIN32
+    struct stat statbuf;
+    if (lstat(path, &statbuf) < 0) {
+        nob_log(NOB_ERROR, "Could not get stat of %s: %s", path, strerror(errno));
+        return (Nob_File_Type)(-1);
+    }
+
+    if (S_ISREG(statbuf.st_mode)) return NOB_FILE_REGULAR;
+    if (S_ISDIR(statbuf.st_mode)) return NOB_FILE_DIRECTORY;
+    if (S_ISLNK(statbuf.st_mode)) return NOB_FILE_SYMLINK;
+    return NOB_FILE_OTHER;
+#endif // _WIN32
+}
+
+NOBDEF bool nob_delete_file(const char *path)
+{
+    nob_log(NOB_INFO, "deleting %s", path);
+    nob_stat_cache_forget(path);
+#ifdef _WIN32
+    if (!DeleteFileA(path)) {
+        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    return true;
+#else
+    if (remove(path) < 0) {
+        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, strerror(errno));
+        return false;
+    }
+    return true;
+#endif // _WIN32
+}
+
+typedef struct {
+    Nob_String_View key;
+    bool valid;           // false after the path was forgotten
+    Nob_File_Stat st;
+} Nob__Stat_Entry;
+
+static struct {
+    Nob__Stat_Entry *items;
+    size_t count;
+    size_t capacity;
+    Nob_Interner paths;
+#ifndef _WIN32
+    pthread_mutex_t mutex;
+#endif // _WIN32
+} nob__stat_cache = {
+    NULL, 0, 0, {0},
+#ifndef _WIN32
+    PTHREAD_MUTEX_INITIALIZER,
+#endif // _WIN32
+};
+
+#ifdef _WIN32
+// Nothing walks in parallel on Windows
+#    define nob__stat_cache_lock()
+#    define nob__stat_cache_unlock()
+#else
+#    define nob__stat_cache_lock() pthread_mutex_lock(&nob__stat_cache.mutex)
+#    define nob__stat_cache_unlock() pthread_mutex_unlock(&nob__stat_cache.mutex)
+#endif // _WIN32
+
+static void nob__stat_cache_put(const char *path, const Nob_File_Stat *st)
+{
+    Nob_String_View key = nob_sv_from_cstr(path);
+    nob__stat_cache_lock();
+    Nob__Stat_Entry *e = (Nob__Stat_Entry*)nob_ht_get(&nob__stat_cache, key);
+    if (e == NULL) e = (Nob__Stat_Entry*)nob_ht_put(&nob__stat_cache, nob_intern(&nob__stat_cache.paths, key));
+    e->valid = true;
+    e->st = *st;
+    nob__stat_cache_unlock();
+}
+
+static bool nob__stat_cache_get(const char *path, Nob_File_Stat *st)
+{
+    nob__stat_cache_lock();
+    Nob__Stat_Entry *e = (Nob__Stat_Entry*)nob_ht_get(&nob__stat_cache, nob_sv_from_cstr(path));
+    bool found = e != NULL && e->valid;
+    if (found) *st = e->st;
+    nob__stat_cache_unlock();
+    return found;
+}
+
+NOBDEF void nob_stat_cache_forget(const char *path)
+{
+    nob__stat_cache_lock();
+    Nob__Stat_Entry *e = (Nob__Stat_Entry*)nob_ht_get(&nob__stat_cache, nob_sv_from_cstr(path));
+    if (e != NULL) e->valid = false;
+    nob__stat_cache_unlock();
+}
+
+NOBDEF void nob_stat_cache_reset(void)
+{
+    nob__stat_cache_lock();
+    nob_ht_foreach(Nob__Stat_Entry, e, &nob__stat_cache) e->valid = false;
+    nob__stat_cache_unlock();
+}
+
+#ifdef _WIN32
+static uint64_t nob__filetime_ns(FILETIME ft)
+{
+    return ((((uint64_t)ft.dwHighDateTime) << 32) | ft.dwLowDateTime)*100;
+}
+
+static Nob_File_Stat nob__file_stat_from_attributes(DWORD attributes, FILETIME mtime, DWORD size_high, DWORD size_low)
+{
+    Nob_File_Stat st = {0};
+    st.type = (attributes & FILE_ATTRIBUTE_DIRECTORY) ? NOB_FILE_DIRECTORY : NOB_FILE_REGULAR;
+    st.mtime_ns = nob__filetime_ns(mtime);
+    st.size = (((uint64_t)size_high) << 32) | size_low;
+    return st;
+}
+#else
+static Nob_File_Stat nob__file_stat_from_stat(const struct stat *statbuf)
+{
+    Nob_File_Stat st = {0};
+    if (S_ISREG(statbuf->st_mode))      st.type = NOB_FILE_REGULAR;
+    else if (S_ISDIR(statbuf->st_mode)) st.type = NOB_FILE_DIRECTORY;
+    else if (S_ISLNK(statbuf->st_mode)) st.type = NOB_FILE_SYMLINK;
+    else                                st.type = NOB_FILE_OTHER;
+    st.mtime_ns = (uint64_t)nob__st_mtim(*statbuf).tv_sec*1000000000ULL + (uint64_t)nob__st_mtim(*statbuf).tv_nsec;
+    st.size = (uint64_t)statbuf->st_size;
+    st.inode = (uint64_t)statbuf->st_ino;
+    return st;
+}
+#endif // _WIN32
+
+// Asks the file system, errno (or GetLastError() on Windows) tells what went wrong
+static bool nob__file_stat_uncached(const char *path, Nob_File_Stat *st)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) return false;
+    *st = nob__file_stat_from_attributes(data.dwFileAttributes, data.ftLastWriteTime, data.nFileSizeHigh, data.nFileSizeLow);
+#else
+    struct stat statbuf;
+    if (stat(path, &statbuf) < 0) return false;
+    *st = nob__file_stat_from_stat(&statbuf);
+#endif // _WIN32
+    return true;
+}
+
+NOBDEF bool nob_file_stat(const char *path, Nob_File_Stat *st)
+{
+    if (nob__stat_cache_get(path, st)) return true;
+    if (!nob__file_stat_uncached(path, st)) return false;
+    nob__stat_cache_put(path, st);
+    return true;
+}
+
+static char *nob__path_join_alloc(const char *dir, const char *name)
+{
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char *path = (char*)malloc(dir_len + 1 + name_len + 1);
+    NOB_ASSERT(path != NULL && "Buy more RAM lool!!");
+    memcpy(path, dir, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+static int nob__compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(const char**)a, *(const char**)b);
+}
+
+#ifdef _WIN32
+NOBDEF bool nob_walk_files(const char *root, Nob_File_Paths *out, bool (*filter)(const char *path), size_t threads)
+{
+    // FindNextFile() already hands out the attributes, times and sizes, there is nothing to stat
+    NOB_UNUSED(threads);
+    bool result = true;
+    size_t first = out->count;
+    Nob_File_Paths dirs = {0};
+    nob_da_append(&dirs, strdup(root));
+
+    while (dirs.count > 0) {
+        char *dir = (char*)dirs.items[--dirs.count];
+        char *pattern = nob__path_join_alloc(dir, "*");
+        WIN32_FIND_DATAA data;
+        HANDLE find = FindFirstFileA(pattern, &data);
+        free(pattern);
+        if (find == INVALID_HANDLE_VALUE) {
+            nob_log(NOB_ERROR, "Could not open directory %s: %s", dir, nob_win32_error_message(GetLastError()));
+            free(dir);
+            result = false;
+            continue;
+        }
+        do {
+            if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0) continue;
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+            char *path = nob__path_join_alloc(dir, data.cFileName);
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                nob_da_append(&dirs, path);
+            } else if (filter == NULL || filter(path)) {
+                Nob_File_Stat st = nob__file_stat_from_attributes(data.dwFileAttributes, data.ftLastWriteTime, data.nFileSizeHigh, data.nFileSizeLow);
+                nob__stat_cache_put(path, &st);
+                nob_da_append(out, path);
+            } else {
+                free(path);
+            }
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+        free(dir);
+    }
+
+    nob_da_free(dirs);
+    qsort(out->items + first, out->count - first, sizeof(*out->items), nob__compare_paths);
+    return result;
+}
+#else
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    Nob_File_Paths dirs;  // directories nobody has read yet
+    size_t busy;          // threads that are reading a directory
+    Nob_File_Paths *out;
+    bool (*filter)(const char *path);
+    bool ok;
+} Nob__Walk;
+
+// Reads one directory without holding the lock, files go to files and subdirectories to dirs
+static bool nob__walk_dir(Nob__Walk *walk, const char *dir, Nob_File_Paths *dirs, Nob_File_Paths *files)
+{
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        nob_log(NOB_ERROR, "Could not open directory %s: %s", dir, strerror(errno));
+        return false;
+    }
+    int fd = dirfd(d);
+
+    struct dirent *ent;
+    while ((errno = 0, ent = readdir(d)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+
+        struct stat statbuf;
+        bool have_stat = false;
+        unsigned char type = DT_UNKNOWN;
+#ifdef _DIRENT_HAVE_D_TYPE
+        type = ent->d_type;
+#endif
+        if (type == DT_UNKNOWN) {
+            // Not every file system fills d_type in
+            if (fstatat(fd, ent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) < 0) continue;
+            have_stat = true;
+            type = S_ISDIR(statbuf.st_mode) ? DT_DIR : S_ISREG(statbuf.st_mode) ? DT_REG : DT_LNK;
+        }
+        if (type != DT_DIR && type != DT_REG) continue;
+
+        char *path = nob__path_join_alloc(dir, ent->d_name);
+        if (type == DT_DIR) {
+            nob_da_append(dirs, path);
+            continue;
+        }
+        if (walk->filter != NULL && !walk->filter(path)) {
+            free(path);
+            continue;
+        }
+        if (!have_stat && fstatat(fd, ent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) < 0) {
+            // deleted while we were looking
+            free(path);
+            continue;
+        }
+        Nob_File_Stat st = nob__file_stat_from_stat(&statbuf);
+        nob__stat_cache_put(path, &st);
+        nob_da_append(files, path);
+    }
+    bool result = errno == 0;
+    if (!result) nob_log(NOB_ERROR, "Could not read directory %s: %s", dir, strerror(errno));
+    closedir(d);
+    return result;
+}
+
+static void *nob__walk_thread(void *arg)
+{
+    Nob__Walk *walk = (Nob__Walk*)arg;
+    Nob_File_Paths dirs = {0};
+    Nob_File_Paths files = {0};
+
+    pthread_mutex_lock(&walk->mutex);
+    for (;;) {
+        while (walk->dirs.count == 0 && walk->busy > 0) pthread_cond_wait(&walk->cond, &walk->mutex);
+        if (walk->dirs.count == 0) break;
+
+        char *dir = (char*)walk->dirs.items[--walk->dirs.count];
+        walk->busy += 1;
+        pthread_mutex_unlock(&walk->mutex);
+
+        dirs.count = 0;
+        files.count = 0;
+        bool ok = nob__walk_dir(walk, dir, &dirs, &files);
+        free(dir);
+
+        pthread_mutex_lock(&walk->mutex);
+        walk->busy -= 1;
+        if (!ok) walk->ok = false;
+        nob_da_append_many(&walk->dirs, dirs.items, dirs.count);
+        nob_da_append_many(walk->out, files.items, files.count);
+        // wake up the others for the new directories, or to let them see that the walk is over
+        if (dirs.count > 0 || walk->busy == 0) pthread_cond_broadcast(&walk->cond);
+    }
+    pthread_mutex_unlock(&walk->mutex);
+
+    nob_da_free(dirs);
+    nob_da_free(files);
+    return NULL;
+}
+
+NOBDEF bool nob_walk_files(const char *root, Nob_File_Paths *out, bool (*filter)(const char *path), size_t threads)
+{
+    Nob__Walk walk = {0};
+    pthread_mutex_init(&walk.mutex, NULL);
+    pthread_cond_init(&walk.cond, NULL);
+    walk.out = out;
+    walk.filter = filter;
+    walk.ok = true;
+    char *root_copy = strdup(root);
+    NOB_ASSERT(root_copy != NULL && "Buy more RAM lool!!");
+    nob_da_append(&walk.dirs, root_copy);
+    size_t first = out->count;
+
+    // The calling thread walks too
+    pthread_t *helpers = NULL;
+    size_t helpers_count = 0;
+    if (threads > 1) {
+        helpers = (pthread_t*)malloc((threads - 1)*sizeof(*helpers));
+        NOB_ASSERT(helpers != NULL && "Buy more RAM lool!!");
+        for (; helpers_count < threads - 1; ++helpers_count) {
+            if (pthread_create(&helpers[helpers_count], NULL, nob__walk_thread, &walk) != 0) break;
+        }
+    }
+    nob__walk_thread(&walk);
+    for (size_t i = 0; i < helpers_count; ++i) pthread_join(helpers[i], NULL);
+    free(helpers);
+
+    nob_da_free(walk.dirs);
+    pthread_cond_destroy(&walk.cond);
+    pthread_mutex_destroy(&walk.mutex);
+    qsort(out->items + first, out->count - first, sizeof(*out->items), nob__compare_paths);
+    return walk.ok;
+}
+#endif // _WIN32
+
+NOBDEF bool nob_copy_directory_recursively(const char *src_path, const char *dst_path)
+{
+    bool result = true;
+    Nob_File_Paths children = {0};
+    Nob_String_Builder src_sb = {0};
+    Nob_String_Builder dst_sb = {0};
+    size_t temp_checkpoint = nob_temp_save();
+
+    Nob_File_Type type = nob_get_file_type(src_path);
+    if (type < 0) return false;
+
+    switch (type) {
+        case NOB_FILE_DIRECTORY: {
+            if (!nob_mkdir_if_not_exists(dst_path)) nob_return_defer(false);
+            if (!nob_read_entire_dir(src_path, &children)) nob_return_defer(false);
+
+            for (size_t i = 0; i < children.count; ++i) {
+                if (strcmp(children.items[i], ".") == 0) continue;
+                if (strcmp(children.items[i], "..") == 0) continue;
+
+                src_sb.count = 0;
+                nob_sb_append_cstr(&src_sb, src_path);
+                nob_sb_append_cstr(&src_sb, "/");
+                nob_sb_append_cstr(&src_sb, children.items[i]);
+                nob_sb_append_null(&src_sb);
+
+                dst_sb.count = 0;
+                nob_sb_append_cstr(&dst_sb, dst_path);
+                nob_sb_append_cstr(&dst_sb, "/");
+                nob_sb_append_cstr(&dst_sb, children.items[i]);
+                nob_sb_append_null(&dst_sb);
+
+                if (!nob_copy_directory_recursively(src_sb.items, dst_sb.items)) {
+                    nob_return_defer(false);
+                }
+            }
+        } break;
+
+        case NOB_FILE_REGULAR: {
+            if (!nob_copy_file(src_path, dst_path)) {
+                nob_return_defer(false);
+            }
+        } break;
+
+        case NOB_FILE_SYMLINK: {
+            nob_log(NOB_WARNING, "TODO: Copying symlinks is not supported yet");
+        } break;
+
+        case NOB_FILE_OTHER: {
+            nob_log(NOB_ERROR, "Unsupported type of file %s", src_path);
+            nob_return_defer(false);
+        } break;
+
+        default: NOB_UNREACHABLE("nob_copy_directory_recursively");
+    }
+
+defer:
+    nob_temp_rewind(temp_checkpoint);
+    nob_da_free(src_sb);
+    nob_da_free(dst_sb);
+    nob_da_free(children);
+    return result;
+}
+
+NOBDEF char *nob_temp_strdup(const char *cstr)
+{
+    size_t n = strlen(cstr);
+    char *result = (char*)nob_temp_alloc(n + 1);
+    NOB_ASSERT(result != NULL && "Buy more RAM lool!!");
+    memcpy(result, cstr, n);
+    result[n] = '\0';
+    return result;
+}
+
+static Nob__Temp_Block *nob__temp_block_map(size_t capacity)
+{
+    size_t size = sizeof(Nob__Temp_Block) + capacity;
+#ifdef _WIN32
+    Nob__Temp_Block *block = (Nob__Temp_Block*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (block == NULL) return NULL;
+#else
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return NULL;
+    Nob__Temp_Block *block = (Nob__Temp_Block*)memory;
+#endif // _WIN32
+    block->prev = NULL;
+    block->next = NULL;
+    block->base = 0;
+    block->capacity = capacity;
+    block->used = 0;
+    nob__temp.stats.mapped += capacity;
+    nob__temp.stats.blocks += 1;
+    return block;
+}
+
+// Unmaps block and all the blocks after it
+static void nob__temp_block_unmap(Nob__Temp_Block *block)
+{
+    while (block != NULL) {
+        Nob__Temp_Block *next = block->next;
+        nob__temp.stats.mapped -= block->capacity;
+        nob__temp.stats.blocks -= 1;
+#ifdef _WIN32
+        VirtualFree(block, 0, MEM_RELEASE);
+#else
+        munmap(block, sizeof(Nob__Temp_Block) + block->capacity);
+#endif // _WIN32
+        block = next;
+    }
+}
+
+NOBDEF void *nob_temp_alloc(size_t requested_size)
+{
+    size_t word_size = sizeof(uintptr_t);
+    size_t size = (requested_size + word_size - 1)/word_size*word_size;
+
+    Nob__Temp_Block *current = nob__temp.current;
+    if (current == NULL || current->used + size > current->capacity) {
+        Nob__Temp_Block *next = current ? current->next : nob__temp.first;
+        if (next != NULL && next->capacity < size) {
+            // A block from before a rewind that is too small, the blocks after it go too so the positions stay in order
+            if (next->prev) next->prev->next = NULL; else nob__temp.first = NULL;
+            nob__temp_block_unmap(next);
+            next = NULL;
+        }
+        if (next == NULL) {
+            next = nob__temp_block_map(size > NOB_TEMP_BLOCK_SIZE ? size : NOB_TEMP_BLOCK_SIZE);
+            if (next == NULL) return NULL;
+            next->prev = current;
+            if (current) {
+                next->base = current->base + current->capacity;
+                current->next = next;
+            } else {
+                nob__temp.first = next;
+            }
+        }
+        next->used = 0;
+        current = nob__temp.current = next;
+    }
+
+    void *result = (char*)(current + 1) + current->used;
+    current->used += size;
+    size_t position = current->base + current->used;
+    if (position > nob__temp.stats.high_water) nob__temp.stats.high_water = position;
+    return result;
+}
+
+NOBDEF char *nob_temp_sprintf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    NOB_ASSERT(n >= 0);
+    char *result = (char*)nob_temp_alloc(n + 1);
+    NOB_ASSERT(result != NULL && "Buy more RAM lool!!");
+    va_start(args, format);
+    vsnprintf(result, n + 1, format, args);
+    va_end(args);
+
+    return result;
+}
+
+NOBDEF void nob_temp_reset(void)
+{
+    nob_temp_rewind(0);
+}
+
+NOBDEF size_t nob_temp_save(void)
+{
+    Nob__Temp_Block *current = nob__temp.current;
+    return current ? current->base + current->used : 0;
+}
+
+NOBDEF void nob_temp_rewind(size_t checkpoint)
+{
+    Nob__Temp_Block *block = nob__temp.current;
+    while (block != NULL && block->base > checkpoint) block = block->prev;
+    if (block == NULL) {
+        // Only position 0 is before the first block
+        NOB_ASSERT(checkpoint == 0);
+        nob__temp.current = NULL;
+        return;
     }
+    NOB_ASSERT(checkpoint - block->base <= block->capacity);
+    block->used = checkpoint - block->base;
+    nob__temp.current = block;
+}
 
-    if (errno != 0) {
-        #ifdef _WIN32
-        nob_log(NOB_ERROR, "Could not read directory %s: %s", parent, nob_win32_error_message(GetLastError()));
-        #else
-        nob_log(NOB_ERROR, "Could not read directory %s: %s", parent, strerror(errno));
-        #endif // _WIN32
-        nob_return_defer(false);
-    }
+NOBDEF void nob_temp_release(void)
+{
+    nob__temp_block_unmap(nob__temp.first);
+    nob__temp.first = NULL;
+    nob__temp.current = NULL;
+}
 
-defer:
-    if (dir) closedir(dir);
+NOBDEF Nob_Temp_Stats nob_temp_stats(void)
+{
+    return nob__temp.stats;
+}
+
+NOBDEF const char *nob_temp_sv_to_cstr(Nob_String_View sv)
+{
+    char *result = (char*)nob_temp_alloc(sv.count + 1);
+    NOB_ASSERT(result != NULL && "Buy more RAM lool!!");
+    memcpy(result, sv.data, sv.count);
+    result[sv.count] = '\0';
     return result;
 }
 
-NOBDEF bool nob_write_entire_file(const char *path, const void *data, size_t size)
+Nob_Manifest nob_manifest = {0};
+
+static Nob_Manifest_Entry *nob__manifest_put(Nob_Manifest_Entries *entries, Nob_String_View path)
 {
-    bool result = true;
+    Nob_Manifest_Entry *entry = (Nob_Manifest_Entry*)nob_ht_get(entries, path);
+    if (entry == NULL) entry = (Nob_Manifest_Entry*)nob_ht_put(entries, nob_intern(&nob_manifest.paths, path));
+    return entry;
+}
 
-    const char *buf = NULL;
-    FILE *f = fopen(path, "wb");
-    if (f == NULL) {
-        nob_log(NOB_ERROR, "Could not open file %s for writing: %s\n", path, strerror(errno));
-        nob_return_defer(false);
+// Content hash of an input, hashed again only when its mtime or size differ from the manifest
+static bool nob__manifest_file_hash(const char *path, const Nob_File_Stat *st, uint64_t *hash)
+{
+    Nob_Manifest_Entry *entry = (Nob_Manifest_Entry*)nob_ht_get(&nob_manifest.files, nob_sv_from_cstr(path));
+    if (entry != NULL && entry->mtime_ns == st->mtime_ns && entry->size == st->size) {
+        *hash = entry->hash;
+        return true;
     }
+    *hash = NOB_HASH_INIT;
+    if (!nob_hash_file(path, hash)) return false;
+    entry = nob__manifest_put(&nob_manifest.files, nob_sv_from_cstr(path));
+    entry->hash = *hash;
+    entry->mtime_ns = st->mtime_ns;
+    entry->size = st->size;
+    nob_manifest.dirty = true;
+    return true;
+}
 
-    //           len
-    //           v
-    // aaaaaaaaaa
-    //     ^
-    //     data
+// Combined hash of the paths and the contents of the inputs
+static bool nob__manifest_inputs_hash(const char **input_paths, size_t input_paths_count, uint64_t *hash)
+{
+    *hash = NOB_HASH_INIT;
+    for (size_t i = 0; i < input_paths_count; ++i) {
+        Nob_File_Stat st;
+        uint64_t file_hash;
+        if (!nob_file_stat(input_paths[i], &st)) return false;
+        if (!nob__manifest_file_hash(input_paths[i], &st, &file_hash)) return false;
+        *hash = nob_hash_bytes(*hash, input_paths[i], strlen(input_paths[i]) + 1);
+        *hash = nob_hash_bytes(*hash, &file_hash, sizeof(file_hash));
+    }
+    return true;
+}
 
-    buf = (const char*)data;
-    while (size > 0) {
-        size_t n = fwrite(buf, 1, size, f);
-        if (ferror(f)) {
-            nob_log(NOB_ERROR, "Could not write into file %s: %s\n", path, strerror(errno));
-            nob_return_defer(false);
+// The same output may be checked against several lists of inputs (its depfile and the build script
+// for example), so the key of an output is its path followed by the hash of the input paths
+#define NOB__MANIFEST_OUTPUT_SUFFIX_LEN 17
+
+static Nob_String_View nob__manifest_output_key(const char *output_path, const char **input_paths, size_t input_paths_count)
+{
+    uint64_t hash = NOB_HASH_INIT;
+    for (size_t i = 0; i < input_paths_count; ++i) {
+        hash = nob_hash_bytes(hash, input_paths[i], strlen(input_paths[i]) + 1);
+    }
+    return nob_sv_from_cstr(nob_temp_sprintf("%s#%016llx", output_path, (unsigned long long)hash));
+}
+
+// Called for an output that is newer than all its inputs: remembers what it was built from
+static void nob__manifest_record(const char *output_path, const Nob_File_Stat *output_stat, const char **input_paths, size_t input_paths_count)
+{
+    Nob_String_View key = nob__manifest_output_key(output_path, input_paths, input_paths_count);
+    Nob_Manifest_Entry *entry = (Nob_Manifest_Entry*)nob_ht_get(&nob_manifest.outputs, key);
+    if (entry != NULL && entry->mtime_ns == output_stat->mtime_ns) return;
+    uint64_t hash;
+    if (!nob__manifest_inputs_hash(input_paths, input_paths_count, &hash)) return;
+    entry = nob__manifest_put(&nob_manifest.outputs, key);
+    entry->hash = hash;
+    entry->mtime_ns = output_stat->mtime_ns;
+    entry->size = input_paths_count;
+    nob_manifest.dirty = true;
+}
+
+// Called for an output that has newer inputs: true if their content is still what the output was built from
+static bool nob__manifest_unchanged(const char *output_path, const Nob_File_Stat *output_stat, const char **input_paths, size_t input_paths_count)
+{
+    Nob_String_View key = nob__manifest_output_key(output_path, input_paths, input_paths_count);
+    Nob_Manifest_Entry *entry = (Nob_Manifest_Entry*)nob_ht_get(&nob_manifest.outputs, key);
+    // NOTE: an output that changed since it was recorded was not necessarily built from the recorded inputs
+    if (entry == NULL || entry->mtime_ns != output_stat->mtime_ns) return false;
+    uint64_t hash;
+    if (!nob__manifest_inputs_hash(input_paths, input_paths_count, &hash)) return false;
+    return hash == entry->hash;
+}
+
+// Entries of files that are gone and of outputs that were rebuilt since they were recorded are of no use anymore
+static bool nob__manifest_entry_is_stale(const Nob_Manifest_Entry *entry, bool output)
+{
+    Nob_String_View path = entry->key;
+    if (output) {
+        if (path.count < NOB__MANIFEST_OUTPUT_SUFFIX_LEN) return true;
+        path.count -= NOB__MANIFEST_OUTPUT_SUFFIX_LEN;
+    }
+    Nob_File_Stat st;
+    if (!nob_file_stat(nob_temp_sv_to_cstr(path), &st)) return true;
+    return output && st.mtime_ns != entry->mtime_ns;
+}
+
+NOBDEF bool nob_manifest_load(const char *path)
+{
+    nob_manifest.enabled = true;
+    nob_manifest.path = path;
+    if (nob_file_exists(path) != 1) return true;
+
+    Nob_String_View file;
+    if (!nob_map_file(path, &file)) return false;
+    Nob_String_View content = file;
+    while (content.count > 0) {
+        // <f|o> <hash> <mtime_ns> <size> <path>
+        Nob_String_View line = nob_sv_chop_by_delim(&content, '\n');
+        Nob_String_View kind = nob_sv_chop_by_delim(&line, ' ');
+        uint64_t numbers[3] = {0};
+        for (size_t i = 0; i < NOB_ARRAY_LEN(numbers); ++i) {
+            Nob_String_View number = nob_sv_chop_by_delim(&line, ' ');
+            for (size_t j = 0; j < number.count && isdigit((unsigned char)number.data[j]); ++j) {
+                numbers[i] = numbers[i]*10 + (uint64_t)(number.data[j] - '0');
+            }
         }
-        size -= n;
-        buf  += n;
+        if (line.count == 0) continue;
+
+        Nob_Manifest_Entries *entries = NULL;
+        if (nob_sv_eq(kind, nob_sv_from_cstr("f"))) entries = &nob_manifest.files;
+        if (nob_sv_eq(kind, nob_sv_from_cstr("o"))) entries = &nob_manifest.outputs;
+        if (entries == NULL) continue;
+        Nob_Manifest_Entry *entry = nob__manifest_put(entries, line);
+        entry->hash = numbers[0];
+        entry->mtime_ns = numbers[1];
+        entry->size = numbers[2];
     }
+    nob_unmap_file(file);
+    return true;
+}
 
-defer:
-    if (f) fclose(f);
+NOBDEF bool nob_manifest_save(void)
+{
+    if (!nob_manifest.enabled || !nob_manifest.dirty) return true;
+    Nob_String_Builder sb = {0};
+    const char *kinds[] = {"f", "o"};
+    Nob_Manifest_Entries *entries[] = {&nob_manifest.files, &nob_manifest.outputs};
+    for (size_t i = 0; i < NOB_ARRAY_LEN(entries); ++i) {
+        nob_ht_foreach(Nob_Manifest_Entry, entry, entries[i]) {
+            size_t mark = nob_temp_save();
+            bool stale = nob__manifest_entry_is_stale(entry, i == 1);
+            nob_temp_rewind(mark);
+            if (stale) continue;
+            nob_sb_appendf(&sb, "%s %llu %llu %llu "SV_Fmt"\n", kinds[i], (unsigned long long)entry->hash,
+                           (unsigned long long)entry->mtime_ns, (unsigned long long)entry->size, SV_Arg(entry->key));
+        }
+    }
+    const char *temp_path = nob_temp_sprintf("%s.tmp", nob_manifest.path);
+    bool result = nob_write_entire_file(temp_path, sb.items, sb.count) && nob_rename(temp_path, nob_manifest.path);
+    nob_sb_free(sb);
+    if (result) nob_manifest.dirty = false;
     return result;
 }
 
-NOBDEF Nob_File_Type nob_get_file_type(const char *path)
+NOBDEF int nob_needs_rebuild(const char *output_path, const char **input_paths, size_t input_paths_count)
 {
+    // NOTE: the output is about to be rebuilt or is fresh already, either way the cache must not remember it
+    nob_stat_cache_forget(output_path);
+    Nob_File_Stat output_stat;
+    if (!nob__file_stat_uncached(output_path, &output_stat)) {
 #ifdef _WIN32
-    DWORD attr = GetFileAttributesA(path);
-    if (attr == INVALID_FILE_ATTRIBUTES) {
-        nob_log(NOB_ERROR, "Could not get file attributes of %s: %s", path, nob_win32_error_message(GetLastError()));
+        // NOTE: if output does not exist it 100% must be rebuilt
+        if (GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND) return 1;
+        nob_log(NOB_ERROR, "Could not get time of %s: %s", output_path, nob_win32_error_message(GetLastError()));
+#else
+        if (errno == ENOENT) return 1;
+        nob_log(NOB_ERROR, "could not stat %s: %s", output_path, strerror(errno));
+#endif // _WIN32
         return -1;
     }
 
-    if (attr & FILE_ATTRIBUTE_DIRECTORY) return NOB_FILE_DIRECTORY;
-    // TODO: detect symlinks on Windows (whatever that means on Windows anyway)
-    return NOB_FILE_REGULAR;
-#else // _WIN32
-    struct stat statbuf;
-    if (lstat(path, &statbuf) < 0) {
-        nob_log(NOB_ERROR, "Could not get stat of %s: %s", path, strerror(errno));
-        return (Nob_File_Type)(-1);
+    bool newer = false;
+    for (size_t i = 0; i < input_paths_count; ++i) {
+        const char *input_path = input_paths[i];
+        Nob_File_Stat input_stat;
+        if (!nob_file_stat(input_path, &input_stat)) {
+            // NOTE: non-existing input is an error cause it is needed for building in the first place
+#ifdef _WIN32
+            nob_log(NOB_ERROR, "Could not get time of %s: %s", input_path, nob_win32_error_message(GetLastError()));
+#else
+            nob_log(NOB_ERROR, "could not stat %s: %s", input_path, strerror(errno));
+#endif // _WIN32
+            return -1;
+        }
+        // NOTE: if even a single input_path is fresher than output_path that's 100% rebuild, unless its content says otherwise
+        if (input_stat.mtime_ns > output_stat.mtime_ns) {
+            if (!nob_manifest.enabled) return 1;
+            newer = true;
+        }
     }
 
-    if (S_ISREG(statbuf.st_mode)) return NOB_FILE_REGULAR;
-    if (S_ISDIR(statbuf.st_mode)) return NOB_FILE_DIRECTORY;
-    if (S_ISLNK(statbuf.st_mode)) return NOB_FILE_SYMLINK;
-    return NOB_FILE_OTHER;
-#endif // _WIN32
+    if (!nob_manifest.enabled) return 0;
+    size_t mark = nob_temp_save();
+    int result = 0;
+    if (!newer) {
+        nob__manifest_record(output_path, &output_stat, input_paths, input_paths_count);
+    } else if (!nob__manifest_unchanged(output_path, &output_stat, input_paths, input_paths_count)) {
+        result = 1;
+    }
+    nob_temp_rewind(mark);
+    return result;
 }
 
-NOBDEF bool nob_delete_file(const char *path)
+NOBDEF int nob_needs_rebuild1(const char *output_path, const char *input_path)
 {
-    nob_log(NOB_INFO, "deleting %s", path);
-#ifdef _WIN32
-    if (!DeleteFileA(path)) {
-        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, nob_win32_error_message(GetLastError()));
-        return false;
+    return nob_needs_rebuild(output_path, &input_path, 1);
+}
+
+NOBDEF uint32_t nob_crc32(uint32_t crc, const void *data, size_t size)
+{
+    static uint32_t table[256];
+    static bool table_ready = false;
+    if (!table_ready) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        table_ready = true;
+    }
+    const unsigned char *bytes = (const unsigned char*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#define NOB__ZIP_LOCAL_HEADER_SIG   0x04034b50
+#define NOB__ZIP_CENTRAL_HEADER_SIG 0x02014b50
+#define NOB__ZIP_END_SIG            0x06054b50
+#define NOB__ZIP_LOCAL_HEADER_SIZE   30
+#define NOB__ZIP_CENTRAL_HEADER_SIZE 46
+#define NOB__ZIP_END_SIZE            22
+// The extra field zipalign pads stored entries with
+#define NOB__ZIP_ALIGNMENT_EXTRA_ID  0xD935
+#define NOB__ZIP_ALIGNMENT_EXTRA_MIN 6
+// 1980-01-01 00:00, so the same inputs give the same archive
+#define NOB__ZIP_DOS_DATE ((0 << 9) | (1 << 5) | 1)
+#define NOB__ZIP_DOS_TIME 0
+
+static uint16_t nob__zip_u16(const unsigned char *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t nob__zip_u32(const unsigned char *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static void nob__zip_put_u16(Nob_String_Builder *sb, uint16_t x)
+{
+    nob_da_append(sb, (char)(x & 0xFF));
+    nob_da_append(sb, (char)(x >> 8));
+}
+
+static void nob__zip_put_u32(Nob_String_Builder *sb, uint32_t x)
+{
+    nob__zip_put_u16(sb, (uint16_t)(x & 0xFFFF));
+    nob__zip_put_u16(sb, (uint16_t)(x >> 16));
+}
+
+static bool nob__zip_pread(FILE *f, uint64_t offset, void *buf, size_t size)
+{
+    if (fseek(f, (long)offset, SEEK_SET) < 0) return false;
+    return fread(buf, 1, size, f) == size;
+}
+
+static bool nob__zip_pwrite(FILE *f, uint64_t offset, const void *buf, size_t size)
+{
+    if (fseek(f, (long)offset, SEEK_SET) < 0) return false;
+    return fwrite(buf, 1, size, f) == size;
+}
+
+// Reads the central directory of the archive in f into zip->items. The sizes and the CRC come from
+// the central directory, so entries written with data descriptors are fine. data_end is the offset of
+// the central directory, which is where the data of the entries ends.
+static bool nob__zip_read_entries(FILE *f, Nob_Zip *zip, uint32_t *data_end)
+{
+    bool result = true;
+    unsigned char *tail = NULL;
+    unsigned char *directory = NULL;
+
+    if (fseek(f, 0, SEEK_END) < 0) nob_return_defer(false);
+    long file_size = ftell(f);
+    if (file_size < NOB__ZIP_END_SIZE) nob_return_defer(false);
+
+    // the end record is followed by a comment of at most 64 KiB
+    size_t tail_size = file_size < NOB__ZIP_END_SIZE + 0xFFFF ? (size_t)file_size : NOB__ZIP_END_SIZE + 0xFFFF;
+    tail = (unsigned char*)malloc(tail_size);
+    NOB_ASSERT(tail != NULL && "Buy more RAM lool!!");
+    if (!nob__zip_pread(f, file_size - tail_size, tail, tail_size)) nob_return_defer(false);
+    const unsigned char *end = NULL;
+    for (size_t i = tail_size - NOB__ZIP_END_SIZE + 1; i-- > 0;) {
+        if (nob__zip_u32(tail + i) == NOB__ZIP_END_SIG) {
+            end = tail + i;
+            break;
+        }
+    }
+    if (end == NULL) nob_return_defer(false);
+
+    uint16_t entries = nob__zip_u16(end + 10);
+    uint32_t directory_size = nob__zip_u32(end + 12);
+    uint32_t directory_offset = nob__zip_u32(end + 16);
+    if ((uint64_t)directory_offset + directory_size > (uint64_t)file_size) nob_return_defer(false);
+    directory = (unsigned char*)malloc(directory_size + 1);
+    NOB_ASSERT(directory != NULL && "Buy more RAM lool!!");
+    if (!nob__zip_pread(f, directory_offset, directory, directory_size)) nob_return_defer(false);
+
+    size_t at = 0;
+    for (uint16_t i = 0; i < entries; ++i) {
+        const unsigned char *h = directory + at;
+        if (at + NOB__ZIP_CENTRAL_HEADER_SIZE > directory_size || nob__zip_u32(h) != NOB__ZIP_CENTRAL_HEADER_SIG) nob_return_defer(false);
+        uint16_t name_len = nob__zip_u16(h + 28);
+        uint16_t extra_len = nob__zip_u16(h + 30);
+        uint16_t comment_len = nob__zip_u16(h + 32);
+        if (at + NOB__ZIP_CENTRAL_HEADER_SIZE + name_len > directory_size) nob_return_defer(false);
+
+        Nob_Zip_Entry entry = {0};
+        entry.method = nob__zip_u16(h + 10);
+        entry.crc32 = nob__zip_u32(h + 16);
+        entry.compressed_size = nob__zip_u32(h + 20);
+        entry.size = nob__zip_u32(h + 24);
+        entry.offset = nob__zip_u32(h + 42);
+
+        // the local header has its own extra field, that is where the alignment padding is
+        unsigned char local[NOB__ZIP_LOCAL_HEADER_SIZE];
+        if (!nob__zip_pread(f, entry.offset, local, sizeof(local)) || nob__zip_u32(local) != NOB__ZIP_LOCAL_HEADER_SIG) nob_return_defer(false);
+        uint32_t data = entry.offset + NOB__ZIP_LOCAL_HEADER_SIZE + nob__zip_u16(local + 26) + nob__zip_u16(local + 28);
+        entry.end = data + entry.compressed_size;
+        // the alignment is not recorded anywhere, the biggest one the data has is kept
+        entry.alignment = 1;
+        while (entry.method == 0 && entry.alignment < 16*1024 && data % (entry.alignment*2) == 0) entry.alignment *= 2;
+
+        entry.name = (char*)malloc(name_len + 1);
+        NOB_ASSERT(entry.name != NULL && "Buy more RAM lool!!");
+        memcpy(entry.name, h + NOB__ZIP_CENTRAL_HEADER_SIZE, name_len);
+        entry.name[name_len] = '\0';
+        nob_da_append(zip, entry);
+        at += NOB__ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len;
+    }
+    *data_end = directory_offset;
+
+defer:
+    free(tail);
+    free(directory);
+    return result;
+}
+
+static void nob__zip_free_entries(Nob_Zip *zip)
+{
+    for (size_t i = 0; i < zip->count; ++i) free(zip->items[i].name);
+    nob_da_free(*zip);
+    zip->items = NULL;
+    zip->count = 0;
+    zip->capacity = 0;
+}
+
+static uint32_t nob__zip_data_offset(const Nob_Zip_Entry *entry)
+{
+    return entry->end - entry->compressed_size;
+}
+
+// Writes the local header of entry at offset into f, padded so the data of a stored entry is aligned.
+// Sets the offset and the end of the entry.
+static bool nob__zip_write_local_header(FILE *f, uint32_t offset, Nob_Zip_Entry *entry)
+{
+    Nob_String_Builder sb = {0};
+    size_t name_len = strlen(entry->name);
+    size_t extra_len = 0;
+    if (entry->method == 0 && entry->alignment > 1) {
+        uint64_t data = (uint64_t)offset + NOB__ZIP_LOCAL_HEADER_SIZE + name_len + NOB__ZIP_ALIGNMENT_EXTRA_MIN;
+        extra_len = NOB__ZIP_ALIGNMENT_EXTRA_MIN + (entry->alignment - data % entry->alignment) % entry->alignment;
+    }
+    nob__zip_put_u32(&sb, NOB__ZIP_LOCAL_HEADER_SIG);
+    nob__zip_put_u16(&sb, entry->method == 0 ? 10 : 20);
+    nob__zip_put_u16(&sb, 0);
+    nob__zip_put_u16(&sb, entry->method);
+    nob__zip_put_u16(&sb, NOB__ZIP_DOS_TIME);
+    nob__zip_put_u16(&sb, NOB__ZIP_DOS_DATE);
+    nob__zip_put_u32(&sb, entry->crc32);
+    nob__zip_put_u32(&sb, entry->compressed_size);
+    nob__zip_put_u32(&sb, entry->size);
+    nob__zip_put_u16(&sb, (uint16_t)name_len);
+    nob__zip_put_u16(&sb, (uint16_t)extra_len);
+    nob_sb_append_buf(&sb, entry->name, name_len);
+    if (extra_len > 0) {
+        nob__zip_put_u16(&sb, NOB__ZIP_ALIGNMENT_EXTRA_ID);
+        nob__zip_put_u16(&sb, (uint16_t)(extra_len - 4));
+        nob__zip_put_u16(&sb, entry->alignment);
+        while (sb.count < NOB__ZIP_LOCAL_HEADER_SIZE + name_len + extra_len) nob_da_append(&sb, 0);
+    }
+    bool result = (uint64_t)offset + sb.count + entry->compressed_size <= 0x7FFFFFFF;
+    if (result) result = nob__zip_pwrite(f, offset, sb.items, sb.count);
+    entry->offset = offset;
+    entry->end = offset + (uint32_t)sb.count + entry->compressed_size;
+    nob_sb_free(sb);
+    return result;
+}
+
+// Copies size bytes from src_offset in src to dst_offset in dst
+static bool nob__zip_copy_bytes(FILE *src, uint32_t src_offset, FILE *dst, uint32_t dst_offset, uint32_t size)
+{
+    char buf[64*1024];
+    while (size > 0) {
+        size_t n = size < sizeof(buf) ? size : sizeof(buf);
+        if (!nob__zip_pread(src, src_offset, buf, n)) return false;
+        if (!nob__zip_pwrite(dst, dst_offset, buf, n)) return false;
+        src_offset += (uint32_t)n;
+        dst_offset += (uint32_t)n;
+        size -= (uint32_t)n;
     }
     return true;
-#else
-    if (remove(path) < 0) {
-        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, strerror(errno));
+}
+
+// An entry with the same name that can stay where it is, NULL if there is none. Any other entry
+// with the name is removed, its data becomes a hole that the next compaction gets rid of.
+static Nob_Zip_Entry *nob__zip_reuse(Nob_Zip *zip, const Nob_Zip_Entry *wanted)
+{
+    for (size_t i = 0; i < zip->count; ++i) {
+        Nob_Zip_Entry *entry = &zip->items[i];
+        if (strcmp(entry->name, wanted->name) != 0) continue;
+        if (!entry->used && entry->method == wanted->method && entry->crc32 == wanted->crc32
+            && entry->size == wanted->size && entry->compressed_size == wanted->compressed_size
+            && nob__zip_data_offset(entry) % wanted->alignment == 0) {
+            entry->used = true;
+            zip->kept += 1;
+            return entry;
+        }
+        free(entry->name);
+        memmove(entry, entry + 1, (zip->count - i - 1)*sizeof(*entry));
+        zip->count -= 1;
+        return NULL;
+    }
+    return NULL;
+}
+
+NOBDEF bool nob_zip_open(Nob_Zip *zip, const char *path)
+{
+    memset(zip, 0, sizeof(*zip));
+    zip->path = path;
+    zip->file = fopen(path, "r+b");
+    if (zip->file != NULL) {
+        if (nob__zip_read_entries(zip->file, zip, &zip->append_offset)) return true;
+        nob_log(NOB_WARNING, "%s: not a ZIP archive nob can update, writing it from scratch", path);
+        nob__zip_free_entries(zip);
+        fclose(zip->file);
+    }
+    zip->append_offset = 0;
+    zip->changed = true;
+    zip->file = fopen(path, "w+b");
+    if (zip->file == NULL) {
+        nob_log(NOB_ERROR, "Could not open file %s for writing: %s", path, strerror(errno));
         return false;
     }
     return true;
-#endif // _WIN32
 }
 
-NOBDEF bool nob_copy_directory_recursively(const char *src_path, const char *dst_path)
+NOBDEF bool nob_zip_add_file(Nob_Zip *zip, const char *name, const char *path, size_t alignment)
 {
-    bool result = true;
-    Nob_File_Paths children = {0};
-    Nob_String_Builder src_sb = {0};
-    Nob_String_Builder dst_sb = {0};
-    size_t temp_checkpoint = nob_temp_save();
+    if (alignment == 0) alignment = 1;
+    // the extra field that pads the data keeps the alignment in 16 bits
+    if (alignment > 0x8000 || (alignment & (alignment - 1)) != 0) {
+        nob_log(NOB_ERROR, "%s: the alignment %zu is not a power of two up to 32768", name, alignment);
+        zip->failed = true;
+        return false;
+    }
 
-    Nob_File_Type type = nob_get_file_type(src_path);
-    if (type < 0) return false;
+    Nob_String_View data;
+    if (!nob_map_file(path, &data)) {
+        zip->failed = true;
+        return false;
+    }
+    if (data.count > 0x7FFFFFFF) {
+        nob_log(NOB_ERROR, "%s: too big for a ZIP archive without ZIP64", path);
+        nob_unmap_file(data);
+        zip->failed = true;
+        return false;
+    }
 
-    switch (type) {
-        case NOB_FILE_DIRECTORY: {
-            if (!nob_mkdir_if_not_exists(dst_path)) nob_return_defer(false);
-            if (!nob_read_entire_dir(src_path, &children)) nob_return_defer(false);
+    Nob_Zip_Entry entry = {0};
+    entry.name = (char*)name;
+    entry.crc32 = nob_crc32(0, data.data, data.count);
+    entry.size = entry.compressed_size = (uint32_t)data.count;
+    entry.alignment = (uint16_t)alignment;
+    entry.used = true;
+    bool result = true;
+    if (nob__zip_reuse(zip, &entry) == NULL) {
+        entry.name = strdup(name);
+        NOB_ASSERT(entry.name != NULL && "Buy more RAM lool!!");
+        result = nob__zip_write_local_header(zip->file, zip->append_offset, &entry)
+              && nob__zip_pwrite(zip->file, nob__zip_data_offset(&entry), data.data, data.count);
+        if (!result) nob_log(NOB_ERROR, "Could not write %s into %s: %s", name, zip->path, strerror(errno));
+        zip->append_offset = entry.end;
+        zip->written += 1;
+        zip->changed = true;
+        nob_da_append(zip, entry);
+    }
+    nob_unmap_file(data);
+    if (!result) zip->failed = true;
+    return result;
+}
 
-            for (size_t i = 0; i < children.count; ++i) {
-                if (strcmp(children.items[i], ".") == 0) continue;
-                if (strcmp(children.items[i], "..") == 0) continue;
+NOBDEF bool nob_zip_add_zip(Nob_Zip *zip, const char *path)
+{
+    bool result = true;
+    Nob_Zip src = {0};
+    uint32_t src_end;
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, strerror(errno));
+        zip->failed = true;
+        return false;
+    }
+    if (!nob__zip_read_entries(f, &src, &src_end)) {
+        nob_log(NOB_ERROR, "%s: not a ZIP archive nob can read", path);
+        nob_return_defer(false);
+    }
 
-                src_sb.count = 0;
-                nob_sb_append_cstr(&src_sb, src_path);
-                nob_sb_append_cstr(&src_sb, "/");
-                nob_sb_append_cstr(&src_sb, children.items[i]);
-                nob_sb_append_null(&src_sb);
+    for (size_t i = 0; i < src.count; ++i) {
+        Nob_Zip_Entry entry = src.items[i];
+        entry.alignment = entry.method == 0 ? 4 : 1;
+        entry.used = true;
+        if (nob__zip_reuse(zip, &entry) != NULL) continue;
+
+        uint32_t src_data = nob__zip_data_offset(&src.items[i]);
+        entry.name = strdup(entry.name);
+        NOB_ASSERT(entry.name != NULL && "Buy more RAM lool!!");
+        bool ok = nob__zip_write_local_header(zip->file, zip->append_offset, &entry)
+               && nob__zip_copy_bytes(f, src_data, zip->file, nob__zip_data_offset(&entry), entry.compressed_size);
+        zip->append_offset = entry.end;
+        zip->written += 1;
+        zip->changed = true;
+        nob_da_append(zip, entry);
+        if (!ok) {
+            nob_log(NOB_ERROR, "Could not copy %s from %s into %s: %s", entry.name, path, zip->path, strerror(errno));
+            nob_return_defer(false);
+        }
+    }
 
-                dst_sb.count = 0;
-                nob_sb_append_cstr(&dst_sb, dst_path);
-                nob_sb_append_cstr(&dst_sb, "/");
-                nob_sb_append_cstr(&dst_sb, children.items[i]);
-                nob_sb_append_null(&dst_sb);
+defer:
+    nob__zip_free_entries(&src);
+    fclose(f);
+    if (!result) zip->failed = true;
+    return result;
+}
 
-                if (!nob_copy_directory_recursively(src_sb.items, dst_sb.items)) {
-                    nob_return_defer(false);
-                }
-            }
-        } break;
+static bool nob__zip_truncate(FILE *f, uint32_t size)
+{
+    fflush(f);
+#ifdef _WIN32
+    return _chsize_s(_fileno(f), size) == 0;
+#else
+    return ftruncate(fileno(f), size) == 0;
+#endif // _WIN32
+}
 
-        case NOB_FILE_REGULAR: {
-            if (!nob_copy_file(src_path, dst_path)) {
-                nob_return_defer(false);
-            }
-        } break;
+static int nob__zip_compare_offsets(const void *a, const void *b)
+{
+    uint32_t x = ((const Nob_Zip_Entry*)a)->offset;
+    uint32_t y = ((const Nob_Zip_Entry*)b)->offset;
+    return x < y ? -1 : x > y;
+}
 
-        case NOB_FILE_SYMLINK: {
-            nob_log(NOB_WARNING, "TODO: Copying symlinks is not supported yet");
-        } break;
+NOBDEF bool nob_zip_close(Nob_Zip *zip)
+{
+    bool result = true;
+    FILE *compacted = NULL;
+    FILE *out = zip->file;
+    const char *compacted_path = nob_temp_sprintf("%s.tmp", zip->path);
+    Nob_String_Builder directory = {0};
+
+    // a reused entry is only checked by its CRC and size, the next build would keep the broken data
+    if (zip->failed) {
+        nob_log(NOB_ERROR, "Not all the entries could be added to %s, deleting it instead of finishing it", zip->path);
+        nob_return_defer(false);
+    }
 
-        case NOB_FILE_OTHER: {
-            nob_log(NOB_ERROR, "Unsupported type of file %s", src_path);
+    // the entries that were not added again are gone from the package
+    size_t live = 0;
+    for (size_t i = 0; i < zip->count;) {
+        if (zip->items[i].used) {
+            live += zip->items[i].end - zip->items[i].offset;
+            i += 1;
+        } else {
+            free(zip->items[i].name);
+            memmove(&zip->items[i], &zip->items[i + 1], (zip->count - i - 1)*sizeof(*zip->items));
+            zip->count -= 1;
+            zip->changed = true;
+        }
+    }
+    // the central directory would come out the same, and the modification time stays
+    if (!zip->changed) nob_return_defer(true);
+
+    // The holes left by replaced entries are only squeezed out once they take a quarter of the
+    // archive, until then the unchanged entries are not touched
+    if ((zip->append_offset - live)*4 > zip->append_offset) {
+        compacted = fopen(compacted_path, "w+b");
+        if (compacted == NULL) {
+            nob_log(NOB_ERROR, "Could not open file %s for writing: %s", compacted_path, strerror(errno));
             nob_return_defer(false);
-        } break;
+        }
+        qsort(zip->items, zip->count, sizeof(*zip->items), nob__zip_compare_offsets);
+        uint32_t offset = 0;
+        for (size_t i = 0; i < zip->count; ++i) {
+            Nob_Zip_Entry *entry = &zip->items[i];
+            uint32_t data = nob__zip_data_offset(entry);
+            if (!nob__zip_write_local_header(compacted, offset, entry)) nob_return_defer(false);
+            if (!nob__zip_copy_bytes(zip->file, data, compacted, nob__zip_data_offset(entry), entry->compressed_size)) nob_return_defer(false);
+            offset = entry->end;
+        }
+        zip->append_offset = offset;
+        out = compacted;
+    }
 
-        default: NOB_UNREACHABLE("nob_copy_directory_recursively");
+    for (size_t i = 0; i < zip->count; ++i) {
+        Nob_Zip_Entry *entry = &zip->items[i];
+        size_t name_len = strlen(entry->name);
+        nob__zip_put_u32(&directory, NOB__ZIP_CENTRAL_HEADER_SIG);
+        nob__zip_put_u16(&directory, 20);
+        nob__zip_put_u16(&directory, entry->method == 0 ? 10 : 20);
+        nob__zip_put_u16(&directory, 0);
+        nob__zip_put_u16(&directory, entry->method);
+        nob__zip_put_u16(&directory, NOB__ZIP_DOS_TIME);
+        nob__zip_put_u16(&directory, NOB__ZIP_DOS_DATE);
+        nob__zip_put_u32(&directory, entry->crc32);
+        nob__zip_put_u32(&directory, entry->compressed_size);
+        nob__zip_put_u32(&directory, entry->size);
+        nob__zip_put_u16(&directory, (uint16_t)name_len);
+        nob__zip_put_u16(&directory, 0);  // extra
+        nob__zip_put_u16(&directory, 0);  // comment
+        nob__zip_put_u16(&directory, 0);  // disk
+        nob__zip_put_u16(&directory, 0);  // internal attributes
+        nob__zip_put_u32(&directory, 0);  // external attributes
+        nob__zip_put_u32(&directory, entry->offset);
+        nob_sb_append_buf(&directory, entry->name, name_len);
+    }
+    uint32_t directory_size = (uint32_t)directory.count;
+    nob__zip_put_u32(&directory, NOB__ZIP_END_SIG);
+    nob__zip_put_u16(&directory, 0);
+    nob__zip_put_u16(&directory, 0);
+    nob__zip_put_u16(&directory, (uint16_t)zip->count);
+    nob__zip_put_u16(&directory, (uint16_t)zip->count);
+    nob__zip_put_u32(&directory, directory_size);
+    nob__zip_put_u32(&directory, zip->append_offset);
+    nob__zip_put_u16(&directory, 0);
+
+    if (!nob__zip_pwrite(out, zip->append_offset, directory.items, directory.count)
+        || !nob__zip_truncate(out, zip->append_offset + (uint32_t)directory.count)) {
+        nob_log(NOB_ERROR, "Could not write the central directory of %s: %s", zip->path, strerror(errno));
+        nob_return_defer(false);
     }
 
 defer:
-    nob_temp_rewind(temp_checkpoint);
-    nob_da_free(src_sb);
-    nob_da_free(dst_sb);
-    nob_da_free(children);
+    nob_sb_free(directory);
+    if (zip->file != NULL && fclose(zip->file) != 0) result = false;
+    zip->file = NULL;
+    if (zip->failed) nob_delete_file(zip->path);
+    if (compacted != NULL) {
+        if (fclose(compacted) != 0) result = false;
+        if (result && !nob_rename(compacted_path, zip->path)) result = false;
+    }
+    nob__zip_free_entries(zip);
     return result;
 }
 
-NOBDEF char *nob_temp_strdup(const char *cstr)
+NOBDEF bool nob_read_depfile(const char *depfile_path, Nob_File_Paths *deps)
 {
-    size_t n = strlen(cstr);
-    char *result = (char*)nob_temp_alloc(n + 1);
-    NOB_ASSERT(result != NULL && "Increase NOB_TEMP_CAPACITY");
-    memcpy(result, cstr, n);
-    result[n] = '\0';
-    return result;
+    Nob_String_View file;
+    if (!nob_map_file(depfile_path, &file)) return false;
+    Nob_String_View content = file;
+    Nob_String_Builder path = {0};
+
+    // Skip the targets. The colon must be followed by a space so "C:\foo.o" does not confuse us.
+    for (;;) {
+        Nob_String_View target = nob_sv_chop_by_delim(&content, ':');
+        if (content.count == 0) {
+            nob_log(NOB_ERROR, "%s: no rule found in the dependency file", depfile_path);
+            nob_unmap_file(file);
+            return false;
+        }
+        NOB_UNUSED(target);
+        if (isspace(content.data[0])) break;
+    }
+
+    while (content.count > 0) {
+        char c = content.data[0];
+        if (c == '\\' && content.count > 1 && (content.data[1] == '\n' || content.data[1] == '\r')) {
+            // line continuation
+            nob_sv_chop_left(&content, 1);
+            content = nob_sv_trim_left(content);
+            continue;
+        }
+        if (c == '\n') break; // end of the first rule, the rest are phony targets from -MP
+        if (isspace(c)) {
+            nob_sv_chop_left(&content, 1);
+            continue;
+        }
+
+        path.count = 0;
+        while (content.count > 0 && !isspace(content.data[0])) {
+            c = content.data[0];
+            if (c == '\\' && content.count > 1 && (content.data[1] == ' ' || content.data[1] == '#')) {
+                nob_sv_chop_left(&content, 1);
+                c = content.data[0];
+            } else if (c == '$' && content.count > 1 && content.data[1] == '$') {
+                nob_sv_chop_left(&content, 1);
+            } else if (c == '\\' && content.count > 1 && (content.data[1] == '\n' || content.data[1] == '\r')) {
+                break;
+            }
+            nob_da_append(&path, c);
+            nob_sv_chop_left(&content, 1);
+        }
+        nob_da_append(deps, nob_temp_sv_to_cstr(nob_sb_to_sv(path)));
+    }
+
+    nob_sb_free(path);
+    nob_unmap_file(file);
+    return true;
 }
 
-NOBDEF void *nob_temp_alloc(size_t requested_size)
+NOBDEF uint64_t nob_hash_bytes(uint64_t hash, const void *data, size_t size)
 {
-    size_t word_size = sizeof(uintptr_t);
-    size_t size = (requested_size + word_size - 1)/word_size*word_size;
-    if (nob_temp_size + size > NOB_TEMP_CAPACITY) return NULL;
-    void *result = &nob_temp[nob_temp_size];
-    nob_temp_size += size;
-    return result;
+    const unsigned char *bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
 }
 
-NOBDEF char *nob_temp_sprintf(const char *format, ...)
+NOBDEF bool nob_hash_file(const char *path, uint64_t *hash)
 {
-    va_list args;
-    va_start(args, format);
-    int n = vsnprintf(NULL, 0, format, args);
-    va_end(args);
+    Nob_String_View file;
+    if (!nob_map_file(path, &file)) return false;
+    *hash = nob_hash_bytes(*hash, file.data, file.count);
+    nob_unmap_file(file);
+    return true;
+}
 
-    NOB_ASSERT(n >= 0);
-    char *result = (char*)nob_temp_alloc(n + 1);
-    NOB_ASSERT(result != NULL && "Extend the size of the temporary allocator");
-    // TODO: use proper arenas for the temporary allocator;
-    va_start(args, format);
-    vsnprintf(result, n + 1, format, args);
-    va_end(args);
+Nob_Cache_Stats nob_cache_stats = {0};
 
-    return result;
+// Finds the binary that running program starts, the way the shell would. Returns NULL if there is none.
+static const char *nob__find_program_temp(const char *program)
+{
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD n = SearchPathA(NULL, program, ".exe", sizeof(path), path, NULL);
+    if (n == 0 || n >= sizeof(path)) return NULL;
+    return nob_temp_strdup(path);
+#else
+    if (strchr(program, '/') != NULL) return program;
+    const char *env_path = getenv("PATH");
+    Nob_String_View dirs = nob_sv_from_cstr(env_path != NULL ? env_path : "/usr/bin:/bin");
+    while (dirs.count > 0) {
+        Nob_String_View dir = nob_sv_chop_by_delim(&dirs, ':');
+        const char *path = nob_temp_sprintf(SV_Fmt"/%s", (int)dir.count, dir.data, program);
+        if (access(path, X_OK) == 0) return path;
+    }
+    return NULL;
+#endif // _WIN32
 }
 
-NOBDEF void nob_temp_reset(void)
+// Mixes the size and the modification time of the compiler binary into hash, so objects of the
+// compiler that was installed before an upgrade are not reused. The binary is looked up once.
+static bool nob__cache_hash_compiler(const char *program, uint64_t *hash)
 {
-    nob_temp_size = 0;
+    static char *last_program = NULL;
+    static Nob_File_Stat last_stat = {0};
+    if (last_program == NULL || strcmp(last_program, program) != 0) {
+        const char *path = nob__find_program_temp(program);
+        if (path == NULL) {
+            nob_log(NOB_ERROR, "Could not find the compiler %s", program);
+            return false;
+        }
+        // stat() follows the links that distributions install compilers behind (cc -> gcc-13)
+        if (!nob__file_stat_uncached(path, &last_stat)) {
+            nob_log(NOB_ERROR, "Could not stat the compiler %s: %s", path, strerror(errno));
+            return false;
+        }
+        free(last_program);
+        last_program = strdup(program);
+        NOB_ASSERT(last_program != NULL && "Buy more RAM lool!!");
+    }
+    *hash = nob_hash_bytes(*hash, &last_stat.size, sizeof(last_stat.size));
+    *hash = nob_hash_bytes(*hash, &last_stat.mtime_ns, sizeof(last_stat.mtime_ns));
+    return true;
 }
 
-NOBDEF size_t nob_temp_save(void)
+NOBDEF bool nob_cache_key(Nob_Cmd cmd, const char *preprocessed_path, uint64_t *key)
 {
-    return nob_temp_size;
+    Nob_String_Builder sb = {0};
+    nob_cmd_render(cmd, &sb);
+    // NOTE: debug info records the working directory, so the same command in another checkout is a different object
+    const char *cwd = nob_get_current_dir_temp();
+    if (cwd == NULL) {
+        nob_sb_free(sb);
+        return false;
+    }
+    nob_sb_append_cstr(&sb, cwd);
+
+    uint64_t hash = nob_hash_bytes(NOB_HASH_INIT, sb.items, sb.count);
+    nob_sb_free(sb);
+    if (cmd.count > 0 && !nob__cache_hash_compiler(cmd.items[0], &hash)) return false;
+    if (!nob_hash_file(preprocessed_path, &hash)) return false;
+    *key = hash;
+    return true;
 }
 
-NOBDEF void nob_temp_rewind(size_t checkpoint)
+static const char *nob__cache_entry_path(uint64_t key, size_t index)
 {
-    nob_temp_size = checkpoint;
+    return nob_temp_sprintf(NOB_CACHE_DIR"/%016llx.%zu", (unsigned long long)key, index);
 }
 
-NOBDEF const char *nob_temp_sv_to_cstr(Nob_String_View sv)
+// Removes the file if it exists. Returns false only on real errors.
+static bool nob__remove_if_exists(const char *path)
 {
-    char *result = (char*)nob_temp_alloc(sv.count + 1);
-    NOB_ASSERT(result != NULL && "Extend the size of the temporary allocator");
-    memcpy(result, sv.data, sv.count);
-    result[sv.count] = '\0';
-    return result;
+    int exists = nob_file_exists(path);
+    if (exists < 0) return false;
+    if (exists == 0) return true;
+#ifdef _WIN32
+    if (!DeleteFileA(path)) {
+        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+#else
+    if (unlink(path) < 0) {
+        nob_log(NOB_ERROR, "Could not delete file %s: %s", path, strerror(errno));
+        return false;
+    }
+#endif // _WIN32
+    return true;
 }
 
-NOBDEF int nob_needs_rebuild(const char *output_path, const char **input_paths, size_t input_paths_count)
+// Sets the modification time of the file to now
+static bool nob__touch_file(const char *path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFile(path, FILE_WRITE_ATTRIBUTES, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    BOOL ok = SetFileTime(file, NULL, NULL, &now);
+    CloseHandle(file);
+    if (!ok) {
+        nob_log(NOB_ERROR, "Could not set time of %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+#else
+    if (utimensat(AT_FDCWD, path, NULL, 0) < 0) {
+        nob_log(NOB_ERROR, "Could not set time of %s: %s", path, strerror(errno));
+        return false;
+    }
+#endif // _WIN32
+    return true;
+}
+
+// Copies src_path to a temporary file next to dst_path and renames it over dst_path, so dst_path
+// never shares its data with src_path (a reflink is copy on write) and is never seen half written
+static bool nob__cache_copy_file(const char *src_path, const char *dst_path)
 {
 #ifdef _WIN32
-    BOOL bSuccess;
+    const char *temp_path = nob_temp_sprintf("%s.%lu.tmp", dst_path, (unsigned long)GetCurrentProcessId());
+#else
+    const char *temp_path = nob_temp_sprintf("%s.%ld.tmp", dst_path, (long)getpid());
+#endif // _WIN32
+    Nob_Log_Level level = nob_minimal_log_level;
+    if (nob_minimal_log_level < NOB_WARNING) nob_minimal_log_level = NOB_WARNING;
+    bool result = nob__remove_if_exists(temp_path) && nob_copy_file(src_path, temp_path) && nob_rename(temp_path, dst_path);
+    if (!result) nob__remove_if_exists(temp_path);
+    nob_minimal_log_level = level;
+    return result;
+}
 
-    HANDLE output_path_fd = CreateFile(output_path, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
-    if (output_path_fd == INVALID_HANDLE_VALUE) {
-        // NOTE: if output does not exist it 100% must be rebuilt
-        if (GetLastError() == ERROR_FILE_NOT_FOUND) return 1;
-        nob_log(NOB_ERROR, "Could not open file %s: %s", output_path, nob_win32_error_message(GetLastError()));
-        return -1;
+NOBDEF int nob_cache_fetch(uint64_t key, const char **output_paths, size_t output_paths_count)
+{
+    int result = 1;
+    size_t temp_checkpoint = nob_temp_save();
+
+    for (size_t i = 0; i < output_paths_count; ++i) {
+        int exists = nob_file_exists(nob__cache_entry_path(key, i));
+        if (exists < 0) nob_return_defer(-1);
+        if (exists == 0) nob_return_defer(0);
     }
-    FILETIME output_path_time;
-    bSuccess = GetFileTime(output_path_fd, NULL, NULL, &output_path_time);
-    CloseHandle(output_path_fd);
-    if (!bSuccess) {
-        nob_log(NOB_ERROR, "Could not get time of %s: %s", output_path, nob_win32_error_message(GetLastError()));
-        return -1;
+
+    for (size_t i = 0; i < output_paths_count; ++i) {
+        if (!nob__cache_copy_file(nob__cache_entry_path(key, i), output_paths[i])) nob_return_defer(-1);
+        // the time of the entry is when it was used last, nob_cache_trim() removes the oldest ones
+        if (!nob__touch_file(nob__cache_entry_path(key, i))) nob_return_defer(-1);
+        // NOTE: the cached file keeps the time of the original compilation which is older than the sources
+        if (!nob__touch_file(output_paths[i])) nob_return_defer(-1);
     }
 
-    for (size_t i = 0; i < input_paths_count; ++i) {
-        const char *input_path = input_paths[i];
-        HANDLE input_path_fd = CreateFile(input_path, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
-        if (input_path_fd == INVALID_HANDLE_VALUE) {
-            // NOTE: non-existing input is an error cause it is needed for building in the first place
-            nob_log(NOB_ERROR, "Could not open file %s: %s", input_path, nob_win32_error_message(GetLastError()));
-            return -1;
-        }
-        FILETIME input_path_time;
-        bSuccess = GetFileTime(input_path_fd, NULL, NULL, &input_path_time);
-        CloseHandle(input_path_fd);
-        if (!bSuccess) {
-            nob_log(NOB_ERROR, "Could not get time of %s: %s", input_path, nob_win32_error_message(GetLastError()));
-            return -1;
+defer:
+    if (result == 0) {
+        for (size_t i = 0; i < output_paths_count; ++i) {
+            if (!nob__remove_if_exists(output_paths[i])) result = -1;
         }
+    }
+    if (result == 1) nob_cache_stats.hits += 1;
+    if (result == 0) nob_cache_stats.misses += 1;
+    nob_temp_rewind(temp_checkpoint);
+    return result;
+}
+
+NOBDEF bool nob_cache_store(uint64_t key, const char **output_paths, size_t output_paths_count)
+{
+    bool result = true;
+    size_t temp_checkpoint = nob_temp_save();
+
+    Nob_Log_Level level = nob_minimal_log_level;
+    nob_minimal_log_level = NOB_WARNING;
+    bool created = nob_mkdir_if_not_exists(NOB_CACHE_DIR);
+    nob_minimal_log_level = level;
+    if (!created) nob_return_defer(false);
 
-        // NOTE: if even a single input_path is fresher than output_path that's 100% rebuild
-        if (CompareFileTime(&input_path_time, &output_path_time) == 1) return 1;
+    for (size_t i = 0; i < output_paths_count; ++i) {
+        if (!nob__cache_copy_file(output_paths[i], nob__cache_entry_path(key, i))) nob_return_defer(false);
     }
 
-    return 0;
-#else
-    struct stat statbuf = {0};
+defer:
+    nob_temp_rewind(temp_checkpoint);
+    return result;
+}
 
-    if (stat(output_path, &statbuf) < 0) {
-        // NOTE: if output does not exist it 100% must be rebuilt
-        if (errno == ENOENT) return 1;
-        nob_log(NOB_ERROR, "could not stat %s: %s", output_path, strerror(errno));
-        return -1;
+typedef struct {
+    const char *path;
+    Nob_File_Stat stat;
+} Nob__Cache_File;
+
+static int nob__cache_compare_files(const void *a, const void *b)
+{
+    uint64_t x = ((const Nob__Cache_File*)a)->stat.mtime_ns;
+    uint64_t y = ((const Nob__Cache_File*)b)->stat.mtime_ns;
+    return x < y ? -1 : x > y;
+}
+
+NOBDEF bool nob_cache_trim(void)
+{
+    bool result = true;
+    Nob_File_Paths paths = {0};
+    Nob__Cache_File *files = NULL;
+    if (nob_file_exists(NOB_CACHE_DIR) != 1) return true;
+    if (!nob_walk_files(NOB_CACHE_DIR, &paths, NULL, 1)) nob_return_defer(false);
+
+    files = (Nob__Cache_File*)malloc(paths.count * sizeof(*files) + 1);
+    NOB_ASSERT(files != NULL && "Buy more RAM lool!!");
+    uint64_t total = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < paths.count; ++i) {
+        Nob__Cache_File *file = &files[count];
+        file->path = paths.items[i];
+        // another nob may have removed it in the meantime
+        if (!nob_file_stat(file->path, &file->stat)) continue;
+        total += file->stat.size;
+        count += 1;
     }
-    int output_path_time = statbuf.st_mtime;
+    if (total <= NOB_CACHE_MAX_SIZE) nob_return_defer(true);
 
-    for (size_t i = 0; i < input_paths_count; ++i) {
-        const char *input_path = input_paths[i];
-        if (stat(input_path, &statbuf) < 0) {
-            // NOTE: non-existing input is an error cause it is needed for building in the first place
-            nob_log(NOB_ERROR, "could not stat %s: %s", input_path, strerror(errno));
-            return -1;
-        }
-        int input_path_time = statbuf.st_mtime;
-        // NOTE: if even a single input_path is fresher than output_path that's 100% rebuild
-        if (input_path_time > output_path_time) return 1;
+    // An entry whose other outputs were removed is a miss, so the files are removed one by one.
+    qsort(files, count, sizeof(*files), nob__cache_compare_files);
+    uint64_t removed = 0;
+    size_t i = 0;
+    for (; i < count && total - removed > NOB_CACHE_MAX_SIZE/4*3; ++i) {
+        if (!nob__remove_if_exists(files[i].path)) nob_return_defer(false);
+        nob_stat_cache_forget(files[i].path);
+        removed += files[i].stat.size;
     }
+    nob_log(NOB_INFO, "Trimmed the build cache by %llu KiB, %zu files were removed",
+            (unsigned long long)(removed/1024), i);
 
-    return 0;
-#endif
+defer:
+    for (size_t i = 0; i < paths.count; ++i) free((char*)paths.items[i]);
+    nob_da_free(paths);
+    free(files);
+    return result;
 }
 
-NOBDEF int nob_needs_rebuild1(const char *output_path, const char *input_path)
+NOBDEF int nob_needs_rebuild_depfile(const char *output_path, const char *depfile_path)
 {
-    return nob_needs_rebuild(output_path, &input_path, 1);
+    int exists = nob_file_exists(depfile_path);
+    if (exists <= 0) return exists < 0 ? -1 : 1;
+
+    Nob_File_Paths deps = {0};
+    int result = 0;
+    size_t temp_checkpoint = nob_temp_save();
+    if (!nob_read_depfile(depfile_path, &deps)) nob_return_defer(-1);
+
+    // NOTE: the include set is different now (a header was removed or renamed), so the output is stale
+    for (size_t i = 0; i < deps.count; ++i) {
+        exists = nob_file_exists(deps.items[i]);
+        if (exists < 0) nob_return_defer(-1);
+        if (exists == 0) nob_return_defer(1);
+    }
+
+    nob_return_defer(nob_needs_rebuild(output_path, deps.items, deps.count));
+
+defer:
+    nob_temp_rewind(temp_checkpoint);
+    nob_da_free(deps);
+    return result;
 }
 
 NOBDEF const char *nob_path_name(const char *path)
@@ -1660,6 +4460,8 @@ NOBDEF const char *nob_path_name(const char *path)
 NOBDEF bool nob_rename(const char *old_path, const char *new_path)
 {
     nob_log(NOB_INFO, "renaming %s -> %s", old_path, new_path);
+    nob_stat_cache_forget(old_path);
+    nob_stat_cache_forget(new_path);
 #ifdef _WIN32
     if (!MoveFileEx(old_path, new_path, MOVEFILE_REPLACE_EXISTING)) {
         nob_log(NOB_ERROR, "could not rename %s to %s: %s", old_path, new_path, nob_win32_error_message(GetLastError()));
@@ -1711,6 +4513,80 @@ defer:
     return result;
 }
 
+NOBDEF bool nob_map_file(const char *path, Nob_String_View *view)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        nob_log(NOB_ERROR, "Could not get size of file %s: %s", path, nob_win32_error_message(GetLastError()));
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        // Empty files can't be mapped
+        CloseHandle(file);
+        *view = nob_sv_from_parts("", 0);
+        return true;
+    }
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        nob_log(NOB_ERROR, "Could not map file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    // The view keeps the mapping alive, so the handle is not needed anymore
+    const char *data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        nob_log(NOB_ERROR, "Could not map file %s: %s", path, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+    *view = nob_sv_from_parts(data, (size_t)size.QuadPart);
+    return true;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        nob_log(NOB_ERROR, "Could not open file %s: %s", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        nob_log(NOB_ERROR, "Could not get stat of %s: %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        // Empty files can't be mapped
+        close(fd);
+        *view = nob_sv_from_parts("", 0);
+        return true;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        nob_log(NOB_ERROR, "Could not map file %s: %s", path, strerror(errno));
+        return false;
+    }
+    *view = nob_sv_from_parts((const char*)data, (size_t)st.st_size);
+    return true;
+#endif
+}
+
+NOBDEF void nob_unmap_file(Nob_String_View view)
+{
+    if (view.count == 0) return;
+#ifdef _WIN32
+    UnmapViewOfFile(view.data);
+#else
+    munmap((void*)view.data, view.count);
+#endif
+}
+
 NOBDEF int nob_sb_appendf(Nob_String_Builder *sb, const char *fmt, ...)
 {
     va_list args;
@@ -1775,6 +4651,121 @@ NOBDEF Nob_String_View nob_sv_from_parts(const char *data, size_t count)
     return sv;
 }
 
+NOBDEF uint64_t nob_sv_hash(Nob_String_View sv)
+{
+    return nob_hash_bytes(NOB_HASH_INIT, sv.data, sv.count);
+}
+
+#define nob__ht_key(items, item_size, i) ((Nob_String_View*)((char*)(items) + (i)*(item_size)))
+
+// The slot of key, or the empty slot where it would go
+static size_t nob__ht_slot(void *items, size_t capacity, size_t item_size, Nob_String_View key)
+{
+    size_t mask = capacity - 1;
+    for (size_t i = nob_sv_hash(key) & mask;; i = (i + 1) & mask) {
+        Nob_String_View *slot = nob__ht_key(items, item_size, i);
+        if (slot->data == NULL) return i;
+        if (slot->count == key.count && memcmp(slot->data, key.data, key.count) == 0) return i;
+    }
+}
+
+NOBDEF void *nob__ht_find(void **items, size_t *count, size_t *capacity, size_t item_size, Nob_String_View key, bool insert)
+{
+    NOB_ASSERT(key.data != NULL && "Keys with NULL data mark the empty slots");
+    if (*capacity == 0) {
+        if (!insert) return NULL;
+    } else {
+        size_t i = nob__ht_slot(*items, *capacity, item_size, key);
+        Nob_String_View *slot = nob__ht_key(*items, item_size, i);
+        if (slot->data != NULL) return slot;
+        if (!insert) return NULL;
+    }
+
+    // Keep the load under 3/4 so the probe sequences stay short
+    if ((*count + 1)*4 > *capacity*3) {
+        size_t new_capacity = *capacity == 0 ? NOB_HT_INIT_CAP : *capacity*2;
+        void *new_items = calloc(new_capacity, item_size);
+        NOB_ASSERT(new_items != NULL && "Buy more RAM lool!!");
+        for (size_t i = 0; i < *capacity; ++i) {
+            Nob_String_View *old = nob__ht_key(*items, item_size, i);
+            if (old->data == NULL) continue;
+            size_t j = nob__ht_slot(new_items, new_capacity, item_size, *old);
+            memcpy(nob__ht_key(new_items, item_size, j), old, item_size);
+        }
+        NOB_FREE(*items);
+        *items = new_items;
+        *capacity = new_capacity;
+    }
+
+    Nob_String_View *slot = nob__ht_key(*items, item_size, nob__ht_slot(*items, *capacity, item_size, key));
+    memset(slot, 0, item_size);
+    *slot = key;
+    *count += 1;
+    return slot;
+}
+
+NOBDEF bool nob__ht_remove(void *items, size_t *count, size_t capacity, size_t item_size, Nob_String_View key)
+{
+    if (capacity == 0) return false;
+    size_t mask = capacity - 1;
+    size_t i = nob__ht_slot(items, capacity, item_size, key);
+    if (nob__ht_key(items, item_size, i)->data == NULL) return false;
+
+    // Shift the entries that probed past the hole back, so no lookup stops at it too early
+    for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+        Nob_String_View *next = nob__ht_key(items, item_size, j);
+        if (next->data == NULL) break;
+        size_t home = nob_sv_hash(*next) & mask;
+        bool reachable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+        if (reachable) {
+            memcpy(nob__ht_key(items, item_size, i), next, item_size);
+            i = j;
+        }
+    }
+    memset(nob__ht_key(items, item_size, i), 0, item_size);
+    *count -= 1;
+    return true;
+}
+
+NOBDEF Nob_String_View nob_intern(Nob_Interner *interner, Nob_String_View sv)
+{
+    Nob_Interned *interned = nob_ht_get(interner, sv);
+    if (interned != NULL) return interned->key;
+
+    size_t size = sv.count + 1;
+    if (interner->block == NULL || interner->block_used + size > interner->block_capacity) {
+        size_t capacity = sizeof(char*) + size;
+        if (capacity < NOB_INTERN_BLOCK_SIZE) capacity = NOB_INTERN_BLOCK_SIZE;
+        char *block = (char*)NOB_REALLOC(NULL, capacity);
+        NOB_ASSERT(block != NULL && "Buy more RAM lool!!");
+        memcpy(block, &interner->block, sizeof(char*));
+        interner->block = block;
+        interner->block_used = sizeof(char*);
+        interner->block_capacity = capacity;
+    }
+    char *copy = interner->block + interner->block_used;
+    memcpy(copy, sv.data, sv.count);
+    copy[sv.count] = '\0';
+    interner->block_used += size;
+
+    Nob_String_View key = nob_sv_from_parts(copy, sv.count);
+    nob_ht_put(interner, key);
+    return key;
+}
+
+NOBDEF void nob_interner_free(Nob_Interner *interner)
+{
+    char *block = interner->block;
+    while (block != NULL) {
+        char *prev;
+        memcpy(&prev, block, sizeof(char*));
+        NOB_FREE(block);
+        block = prev;
+    }
+    nob_ht_free(*interner);
+    memset(interner, 0, sizeof(*interner));
+}
+
 NOBDEF Nob_String_View nob_sv_trim_left(Nob_String_View sv)
 {
     size_t i = 0;
@@ -2028,6 +5019,11 @@ NOBDEF int closedir(DIR *dirp)
         #define write_entire_file nob_write_entire_file
         #define get_file_type nob_get_file_type
         #define delete_file nob_delete_file
+        #define File_Stat Nob_File_Stat
+        #define file_stat nob_file_stat
+        #define stat_cache_forget nob_stat_cache_forget
+        #define stat_cache_reset nob_stat_cache_reset
+        #define walk_files nob_walk_files
         #define return_defer nob_return_defer
         #define da_append nob_da_append
         #define da_free nob_da_free
@@ -2039,6 +5035,8 @@ NOBDEF int closedir(DIR *dirp)
         #define da_foreach nob_da_foreach
         #define String_Builder Nob_String_Builder
         #define read_entire_file nob_read_entire_file
+        #define map_file nob_map_file
+        #define unmap_file nob_unmap_file
         #define sb_appendf nob_sb_appendf
         #define sb_append_buf nob_sb_append_buf
         #define sb_append_cstr nob_sb_append_cstr
@@ -2056,6 +5054,10 @@ NOBDEF int closedir(DIR *dirp)
         #define procs_wait nob_procs_wait
         #define procs_wait_and_reset nob_procs_wait_and_reset
         #define procs_append_with_flush nob_procs_append_with_flush
+        #define procs_wait_any nob_procs_wait_any
+        #define procs_wait_for_slot nob_procs_wait_for_slot
+        #define jobserver_init nob_jobserver_init
+        #define jobserver_active nob_jobserver_active
         #define Cmd Nob_Cmd
         #define Cmd_Redirect Nob_Cmd_Redirect
         #define Cmd_Opt Nob_Cmd_Opt
@@ -2080,11 +5082,53 @@ NOBDEF int closedir(DIR *dirp)
         #define temp_reset nob_temp_reset
         #define temp_save nob_temp_save
         #define temp_rewind nob_temp_rewind
+        #define temp_release nob_temp_release
+        #define Temp_Stats Nob_Temp_Stats
+        #define temp_stats nob_temp_stats
         #define path_name nob_path_name
         // NOTE: rename(2) is widely known POSIX function. We never wanna collide with it.
         // #define rename nob_rename
         #define needs_rebuild nob_needs_rebuild
+        #define Manifest_Entry Nob_Manifest_Entry
+        #define Manifest_Entries Nob_Manifest_Entries
+        #define Manifest Nob_Manifest
+        #define manifest_load nob_manifest_load
+        #define manifest_save nob_manifest_save
+        #define Zip_Entry Nob_Zip_Entry
+        #define Zip Nob_Zip
+        #define zip_open nob_zip_open
+        #define zip_add_file nob_zip_add_file
+        #define zip_add_zip nob_zip_add_zip
+        #define zip_close nob_zip_close
         #define needs_rebuild1 nob_needs_rebuild1
+        #define read_depfile nob_read_depfile
+        #define needs_rebuild_depfile nob_needs_rebuild_depfile
+        #define hash_bytes nob_hash_bytes
+        #define hash_file nob_hash_file
+        #define Trace_Event Nob_Trace_Event
+        #define Trace Nob_Trace
+        #define time_usec nob_time_usec
+        #define trace_write_json nob_trace_write_json
+        #define trace_log_slowest nob_trace_log_slowest
+        #define trace_reset nob_trace_reset
+        #define Compdb_Entry Nob_Compdb_Entry
+        #define Compdb Nob_Compdb
+        #define compdb_record nob_compdb_record
+        #define compdb_write nob_compdb_write
+        #define compdb_reset nob_compdb_reset
+        #define Capture Nob_Capture
+        #define capture_start nob_capture_start
+        #define captures_wait nob_captures_wait
+        #define cmd_run_capture nob_cmd_run_capture
+        #define capture_free nob_capture_free
+        #define Cache_Stats Nob_Cache_Stats
+        #define cache_stats nob_cache_stats
+        #define Copy_Stats Nob_Copy_Stats
+        #define copy_stats nob_copy_stats
+        #define cache_key nob_cache_key
+        #define cache_fetch nob_cache_fetch
+        #define cache_store nob_cache_store
+        #define cache_trim nob_cache_trim
         #define file_exists nob_file_exists
         #define get_current_dir_temp nob_get_current_dir_temp
         #define set_current_dir nob_set_current_dir
@@ -2101,6 +5145,16 @@ NOBDEF int closedir(DIR *dirp)
         #define sv_from_cstr nob_sv_from_cstr
         #define sv_from_parts nob_sv_from_parts
         #define sb_to_sv nob_sb_to_sv
+        #define sv_hash nob_sv_hash
+        #define ht_get nob_ht_get
+        #define ht_put nob_ht_put
+        #define ht_remove nob_ht_remove
+        #define ht_foreach nob_ht_foreach
+        #define ht_free nob_ht_free
+        #define Interned Nob_Interned
+        #define Interner Nob_Interner
+        #define intern nob_intern
+        #define interner_free nob_interner_free
         #define win32_error_message nob_win32_error_message
     #endif // NOB_STRIP_PREFIX
 #endif // NOB_STRIP_PREFIX_GUARD_
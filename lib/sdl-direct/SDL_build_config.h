@@ -0,0 +1,293 @@
+/*
+  Hand-maintained SDL_build_config.h for building SDL on Linux without cmake (`./nob sdl-direct`).
+
+  It mirrors what SDL's cmake generates on a typical glibc desktop. Optional backends are turned
+  on only when their development headers are installed, and all of them are loaded with dlopen()
+  at runtime (the *_DYNAMIC defines), so the app itself never links against X11, Wayland,
+  PulseAudio, PipeWire or ALSA.
+
+  Keep it in sync with lib/SDL-3.2.16/include/build_config/SDL_build_config.h.cmake when
+  updating SDL.
+*/
+
+#ifndef SDL_build_config_h_
+#define SDL_build_config_h_
+
+#include <SDL3/SDL_platform_defines.h>
+
+#ifndef SDL_PLATFORM_LINUX
+#error "lib/sdl-direct/SDL_build_config.h only supports Linux"
+#endif
+
+#define HAVE_GCC_ATOMICS 1
+
+#define HAVE_FLOAT_H 1
+#define HAVE_STDARG_H 1
+#define HAVE_STDDEF_H 1
+#define HAVE_STDINT_H 1
+
+#define HAVE_LIBC 1
+#ifdef HAVE_LIBC
+#define HAVE_ALLOCA_H 1
+#define HAVE_ICONV_H 1
+#define HAVE_INTTYPES_H 1
+#define HAVE_LIMITS_H 1
+#define HAVE_MALLOC_H 1
+#define HAVE_MATH_H 1
+#define HAVE_MEMORY_H 1
+#define HAVE_SIGNAL_H 1
+#define HAVE_STDIO_H 1
+#define HAVE_STDLIB_H 1
+#define HAVE_STRINGS_H 1
+#define HAVE_STRING_H 1
+#define HAVE_SYS_TYPES_H 1
+#define HAVE_WCHAR_H 1
+#define HAVE_DLOPEN 1
+#define HAVE_MALLOC 1
+#define HAVE_FDATASYNC 1
+#define HAVE_GETENV 1
+#define HAVE_GETHOSTNAME 1
+#define HAVE_SETENV 1
+#define HAVE_PUTENV 1
+#define HAVE_UNSETENV 1
+#define HAVE_ABS 1
+#define HAVE_BCOPY 1
+#define HAVE_MEMSET 1
+#define HAVE_MEMCPY 1
+#define HAVE_MEMMOVE 1
+#define HAVE_MEMCMP 1
+#define HAVE_WCSLEN 1
+#define HAVE_WCSNLEN 1
+#define HAVE_WCSSTR 1
+#define HAVE_WCSCMP 1
+#define HAVE_WCSNCMP 1
+#define HAVE_WCSTOL 1
+#define HAVE_STRLEN 1
+#define HAVE_STRNLEN 1
+#define HAVE_STRPBRK 1
+#define HAVE_INDEX 1
+#define HAVE_RINDEX 1
+#define HAVE_STRCHR 1
+#define HAVE_STRRCHR 1
+#define HAVE_STRSTR 1
+#define HAVE_STRTOK_R 1
+#define HAVE_STRTOL 1
+#define HAVE_STRTOUL 1
+#define HAVE_STRTOLL 1
+#define HAVE_STRTOULL 1
+#define HAVE_STRTOD 1
+#define HAVE_ATOI 1
+#define HAVE_ATOF 1
+#define HAVE_STRCMP 1
+#define HAVE_STRNCMP 1
+#define HAVE_VSSCANF 1
+#define HAVE_VSNPRINTF 1
+#define HAVE_ACOS 1
+#define HAVE_ACOSF 1
+#define HAVE_ASIN 1
+#define HAVE_ASINF 1
+#define HAVE_ATAN 1
+#define HAVE_ATANF 1
+#define HAVE_ATAN2 1
+#define HAVE_ATAN2F 1
+#define HAVE_CEIL 1
+#define HAVE_CEILF 1
+#define HAVE_COPYSIGN 1
+#define HAVE_COPYSIGNF 1
+#define HAVE_COS 1
+#define HAVE_COSF 1
+#define HAVE_EXP 1
+#define HAVE_EXPF 1
+#define HAVE_FABS 1
+#define HAVE_FABSF 1
+#define HAVE_FLOOR 1
+#define HAVE_FLOORF 1
+#define HAVE_FMOD 1
+#define HAVE_FMODF 1
+#define HAVE_ISINF 1
+#define HAVE_ISINFF 1
+#define HAVE_ISINF_FLOAT_MACRO 1
+#define HAVE_ISNAN 1
+#define HAVE_ISNANF 1
+#define HAVE_ISNAN_FLOAT_MACRO 1
+#define HAVE_LOG 1
+#define HAVE_LOGF 1
+#define HAVE_LOG10 1
+#define HAVE_LOG10F 1
+#define HAVE_LROUND 1
+#define HAVE_LROUNDF 1
+#define HAVE_MODF 1
+#define HAVE_MODFF 1
+#define HAVE_POW 1
+#define HAVE_POWF 1
+#define HAVE_ROUND 1
+#define HAVE_ROUNDF 1
+#define HAVE_SCALBN 1
+#define HAVE_SCALBNF 1
+#define HAVE_SIN 1
+#define HAVE_SINF 1
+#define HAVE_SQRT 1
+#define HAVE_SQRTF 1
+#define HAVE_TAN 1
+#define HAVE_TANF 1
+#define HAVE_TRUNC 1
+#define HAVE_TRUNCF 1
+#define HAVE_FOPEN64 1
+#define HAVE_FSEEKO 1
+#define HAVE_FSEEKO64 1
+#define HAVE_MEMFD_CREATE 1
+#define HAVE_POSIX_FALLOCATE 1
+#define HAVE_SIGACTION 1
+#define HAVE_SA_SIGACTION 1
+#define HAVE_ST_MTIM 1
+#define HAVE_SETJMP 1
+#define HAVE_NANOSLEEP 1
+#define HAVE_GMTIME_R 1
+#define HAVE_LOCALTIME_R 1
+#define HAVE_NL_LANGINFO 1
+#define HAVE_SYSCONF 1
+#define HAVE_CLOCK_GETTIME 1
+#define HAVE_GETPAGESIZE 1
+#define HAVE_ICONV 1
+#define HAVE_PTHREAD_SETNAME_NP 1
+#define HAVE_SEM_TIMEDWAIT 1
+#define HAVE_GETAUXVAL 1
+#define HAVE_POLL 1
+#define HAVE__EXIT 1
+#endif /* HAVE_LIBC */
+
+#define HAVE_INOTIFY_INIT1 1
+#define HAVE_INOTIFY 1
+#define HAVE_O_CLOEXEC 1
+#define HAVE_LINUX_INPUT_H 1
+
+#if __has_include(<libudev.h>)
+#define HAVE_LIBUDEV_H 1
+#define SDL_UDEV_DYNAMIC "libudev.so.1"
+#endif
+
+/* Audio */
+#define SDL_AUDIO_DRIVER_DISK 1
+#define SDL_AUDIO_DRIVER_DUMMY 1
+
+#if __has_include(<pulse/pulseaudio.h>)
+#define SDL_AUDIO_DRIVER_PULSEAUDIO 1
+#define SDL_AUDIO_DRIVER_PULSEAUDIO_DYNAMIC "libpulse.so.0"
+#endif
+
+/* nob adds the include flags of `pkg-config --cflags libpipewire-0.3` for these */
+#if __has_include(<pipewire/pipewire.h>) && __has_include(<spa/param/audio/format-utils.h>)
+#define SDL_AUDIO_DRIVER_PIPEWIRE 1
+#define SDL_AUDIO_DRIVER_PIPEWIRE_DYNAMIC "libpipewire-0.3.so.0"
+#endif
+
+#if __has_include(<alsa/asoundlib.h>)
+#define SDL_AUDIO_DRIVER_ALSA 1
+#define SDL_AUDIO_DRIVER_ALSA_DYNAMIC "libasound.so.2"
+#endif
+
+/* Input, joystick, haptic, sensor */
+#define SDL_INPUT_LINUXEV 1
+#define SDL_INPUT_LINUXKD 1
+#define SDL_JOYSTICK_HIDAPI 1
+#define SDL_JOYSTICK_LINUX 1
+#define SDL_JOYSTICK_VIRTUAL 1
+#define SDL_HAPTIC_LINUX 1
+#define SDL_SENSOR_DUMMY 1
+
+/* OS backends */
+#define SDL_PROCESS_POSIX 1
+#define SDL_LOADSO_DLOPEN 1
+#define SDL_THREAD_PTHREAD 1
+#define SDL_THREAD_PTHREAD_RECURSIVE_MUTEX 1
+#define SDL_TIME_UNIX 1
+#define SDL_TIMER_UNIX 1
+#define SDL_POWER_LINUX 1
+#define SDL_FILESYSTEM_UNIX 1
+#define SDL_FSOPS_POSIX 1
+#define SDL_STORAGE_STEAM 1
+#define DYNAPI_NEEDS_DLOPEN 1
+
+/* Video */
+#define SDL_VIDEO_DRIVER_DUMMY 1
+#define SDL_VIDEO_DRIVER_OFFSCREEN 1
+
+#if __has_include(<X11/Xlib.h>) && __has_include(<X11/extensions/Xext.h>)
+#define SDL_VIDEO_DRIVER_X11 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC "libX11.so.6"
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XEXT "libXext.so.6"
+#define SDL_VIDEO_DRIVER_X11_HAS_XKBLOOKUPKEYSYM 1
+#define SDL_VIDEO_DRIVER_X11_SUPPORTS_GENERIC_EVENTS 1
+#if __has_include(<X11/Xcursor/Xcursor.h>)
+#define SDL_VIDEO_DRIVER_X11_XCURSOR 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XCURSOR "libXcursor.so.1"
+#endif
+#if __has_include(<X11/extensions/Xdbe.h>)
+#define SDL_VIDEO_DRIVER_X11_XDBE 1
+#endif
+#if __has_include(<X11/extensions/XInput2.h>)
+#define SDL_VIDEO_DRIVER_X11_XINPUT2 1
+#define SDL_VIDEO_DRIVER_X11_XINPUT2_SUPPORTS_MULTITOUCH 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XINPUT2 "libXi.so.6"
+/* XFixes pointer barriers are used together with XInput2 */
+#if __has_include(<X11/extensions/Xfixes.h>)
+#define SDL_VIDEO_DRIVER_X11_XFIXES 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XFIXES "libXfixes.so.3"
+#endif
+#endif
+#if __has_include(<X11/extensions/Xrandr.h>)
+#define SDL_VIDEO_DRIVER_X11_XRANDR 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XRANDR "libXrandr.so.2"
+#endif
+#if __has_include(<X11/extensions/scrnsaver.h>)
+#define SDL_VIDEO_DRIVER_X11_XSCRNSAVER 1
+#define SDL_VIDEO_DRIVER_X11_DYNAMIC_XSS "libXss.so.1"
+#endif
+#if __has_include(<X11/extensions/shape.h>)
+#define SDL_VIDEO_DRIVER_X11_XSHAPE 1
+#endif
+#if __has_include(<X11/extensions/sync.h>)
+#define SDL_VIDEO_DRIVER_X11_XSYNC 1
+#endif
+#else
+/* Prevent Mesa from including X11 headers */
+#define MESA_EGL_NO_X11_HEADERS 1
+#define EGL_NO_X11 1
+#endif
+
+/* The protocol headers are generated by nob with wayland-scanner into the include path */
+#if __has_include(<wayland-client.h>) && __has_include(<wayland-egl.h>) && __has_include(<wayland-cursor.h>) && \
+    __has_include(<xkbcommon/xkbcommon.h>) && __has_include(<xdg-shell-client-protocol.h>)
+#define SDL_VIDEO_DRIVER_WAYLAND 1
+#define SDL_VIDEO_DRIVER_WAYLAND_DYNAMIC "libwayland-client.so.0"
+#define SDL_VIDEO_DRIVER_WAYLAND_DYNAMIC_EGL "libwayland-egl.so.1"
+#define SDL_VIDEO_DRIVER_WAYLAND_DYNAMIC_CURSOR "libwayland-cursor.so.0"
+#define SDL_VIDEO_DRIVER_WAYLAND_DYNAMIC_XKBCOMMON "libxkbcommon.so.0"
+#endif
+
+/* Khronos headers are bundled with SDL in src/video/khronos */
+#define SDL_VIDEO_RENDER_GPU 1
+#define SDL_VIDEO_RENDER_VULKAN 1
+#define SDL_VIDEO_RENDER_OGL 1
+#define SDL_VIDEO_RENDER_OGL_ES2 1
+#define SDL_VIDEO_OPENGL 1
+#define SDL_VIDEO_OPENGL_ES 1
+#define SDL_VIDEO_OPENGL_ES2 1
+#define SDL_VIDEO_OPENGL_GLX 1
+#define SDL_VIDEO_OPENGL_EGL 1
+#define SDL_VIDEO_VULKAN 1
+#define SDL_GPU_VULKAN 1
+
+/* Camera */
+#define SDL_CAMERA_DRIVER_DUMMY 1
+#define SDL_CAMERA_DRIVER_V4L2 1
+
+#if !defined(__loongarch64)
+#define SDL_DISABLE_LSX 1
+#define SDL_DISABLE_LASX 1
+#endif
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+#define SDL_DISABLE_NEON 1
+#endif
+
+#endif /* SDL_build_config_h_ */
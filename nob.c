@@ -1,5 +1,6 @@
 #define NOB_STRIP_PREFIX
 #define NOB_IMPLEMENTATION
+#define NOB_CACHE_DIR "build/.cache"
 #include "include/nob.h"
 
 #include <time.h>
@@ -8,6 +9,14 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <signal.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
 typedef enum {
     CLANG = 0,
     GCC = 1,
@@ -19,6 +28,7 @@ typedef struct {
     String_View android_ndk_location;
     String_View android_sdk_location;
     String_View android_java_home;
+    String_View android_abis;
 } Env;
 
 typedef enum {
@@ -34,6 +44,10 @@ typedef struct {
     bool force_rebuild;
     bool should_run;
     bool device;
+    bool sdl_direct;
+    bool unity;
+    bool pch;
+    bool pgo;
 } Config;
 
 Config config = {0};
@@ -49,9 +63,13 @@ Nob_Cmd cmd = {0};
 
 #define ANDROID_TOOLS "34.0.0"
 #define ANDROID_API 34 // 34 seems to be minimal requirement of sdl
-#define ANDROID_ABI "arm64-v8a"
+// what goes into the apk unless env ANDROID_ABIS lists others, x86_64 is for the emulator
+#define ANDROID_ABIS "arm64-v8a,armeabi-v7a,x86_64"
+// native libraries are stored page aligned so they can be mapped right out of the apk,
+// devices with Android 15 may use 16 KiB pages
+#define ANDROID_PAGE_SIZE (16*1024)
 
-// we keep this file between builds, since build/android folder is removed
+// kept outside of build/android, so a new key is not made whenever that folder is removed by hand
 #define ANDROID_KEYSTORE_FILE BUILD_FOLDER"/keystore_android.keystore"
 
 char *config_platform_name(Platform platform) {
@@ -69,6 +87,10 @@ void dump_config_to_file(const char *path, Config config) {
     sb_append_cstr(&sb, temp_sprintf("optimize=%d\n", config.optimize));
     sb_append_cstr(&sb, temp_sprintf("platform=%d\n", config.platform));
     sb_append_cstr(&sb, temp_sprintf("device=%d\n", config.device));
+    sb_append_cstr(&sb, temp_sprintf("sdl_direct=%d\n", config.sdl_direct));
+    sb_append_cstr(&sb, temp_sprintf("unity=%d\n", config.unity));
+    sb_append_cstr(&sb, temp_sprintf("pch=%d\n", config.pch));
+    sb_append_cstr(&sb, temp_sprintf("pgo=%d\n", config.pgo));
     write_entire_file(path, sb.items, sb.count);
     sb_free(sb);
 }
@@ -98,11 +120,38 @@ unsigned long long get_timestamp_usec(void) {
 }
 #endif
 
+typedef struct {
+    String_View key;
+    String_View *value;
+} Env_Var;
+
+typedef struct {
+    Env_Var *items;
+    size_t count;
+    size_t capacity;
+} Env_Vars;
+
 bool parse_environment(void) {
-    Nob_String_Builder sb = {0};
-    if (!nob_read_entire_file("env", &sb)) return true; // in case we don't care
+    if (!file_exists("env")) return true; // in case we don't care
+    String_View sv;
+    if (!map_file("env", &sv)) return false;
+    String_View mapped = sv;
+
+    struct { const char *name; String_View *value; } known[] = {
+        { "APPLE_DEVELOPER_NAME", &env.apple_developer_name },
+        { "IOS_DEVICE_ID",        &env.ios_device_id },
+        { "ANDROID_NDK_LOCATION", &env.android_ndk_location },
+        { "ANDROID_SDK_LOCATION", &env.android_sdk_location },
+        { "ANDROID_JAVA_HOME",    &env.android_java_home },
+        { "ANDROID_ABIS",         &env.android_abis },
+    };
+    Env_Vars vars = {0};
+    for (size_t i = 0; i < ARRAY_LEN(known); ++i) {
+        Env_Var *var = ht_put(&vars, sv_from_cstr(known[i].name));
+        var->value = known[i].value;
+    }
 
-    String_View sv = sv_from_parts(sb.items, sb.count);
+    bool result = true;
     while (sv.count > 0) {
         String_View line = sv_chop_by_delim(&sv, '\n');
 
@@ -112,23 +161,21 @@ bool parse_environment(void) {
         String_View name = sv_chop_by_delim(&line, '=');
         if (name.count == 0) continue;
 
-        if (sv_eq(name, sv_from_cstr("APPLE_DEVELOPER_NAME"))) {
-            env.apple_developer_name = line;
-        } else if (sv_eq(name, sv_from_cstr("IOS_DEVICE_ID"))) {
-            env.ios_device_id = line;
-        } else if (sv_eq(name, sv_from_cstr("ANDROID_NDK_LOCATION"))) {
-            env.android_ndk_location = line;
-        } else if (sv_eq(name, sv_from_cstr("ANDROID_SDK_LOCATION"))) {
-            env.android_sdk_location = line;
-        } else if (sv_eq(name, sv_from_cstr("ANDROID_JAVA_HOME"))) {
-            env.android_java_home = line;
-        } else {
+        Env_Var *var = ht_get(&vars, name);
+        if (var == NULL) {
             nob_log(NOB_ERROR, "Unexpected variable name '"SV_Fmt"'", SV_Arg(name));
-            return false;
+            return_defer(false);
         }
+        // copied, since the mapping goes away and the file may be edited while a daemon still runs
+        const char *value = strdup(temp_sv_to_cstr(line));
+        NOB_ASSERT(value != NULL && "Buy more RAM lool!!");
+        *var->value = sv_from_cstr(value);
     }
 
-    return true;
+defer:
+    ht_free(vars);
+    unmap_file(mapped);
+    return result;
 }
 
 bool parse_config_from_args(int *argc, char ***argv, Config *config) {
@@ -150,6 +197,15 @@ bool parse_config_from_args(int *argc, char ***argv, Config *config) {
             config->platform = IOS;
         } else if (strcmp(arg, "-device") == 0) {
             config->device = true;
+        } else if (strcmp(arg, "-sdl-direct") == 0) {
+            config->sdl_direct = true;
+        } else if (strcmp(arg, "-unity") == 0) {
+            config->unity = true;
+        } else if (strcmp(arg, "-pch") == 0) {
+            config->pch = true;
+        } else if (strcmp(arg, "-pgo") == 0) {
+            config->pgo = true;
+            config->optimize = true;
         } else {
             nob_log(NOB_ERROR, "Unexpected argument: %s", arg);
             return false;
@@ -164,8 +220,8 @@ bool parse_config_from_args(int *argc, char ***argv, Config *config) {
 #endif
 
     if (config->platform != PLATFORM_NATIVE) {
-        if (config->force_rebuild) {
-            nob_log(NOB_ERROR, "Force Rebuild flag makes no sense on iOS or Android, since this script always does a clean build on mobile platforms.");
+        if (config->force_rebuild && config->platform == IOS) {
+            nob_log(NOB_ERROR, "Force Rebuild flag makes no sense on iOS, since this script always does a clean build there.");
             return false;
         }
 
@@ -173,7 +229,38 @@ bool parse_config_from_args(int *argc, char ***argv, Config *config) {
             nob_log(NOB_ERROR, "Compiler flag is not supported on iOS or Android, since we can't freely choose here.");
             return false;
         }
+
+        if (config->sdl_direct) {
+            nob_log(NOB_ERROR, "SDL can only be built without cmake for the native Linux build.");
+            return false;
+        }
+
+        if (config->unity) {
+            nob_log(NOB_ERROR, "Unity builds are only supported for the native build.");
+            return false;
+        }
+
+        if (config->pch) {
+            nob_log(NOB_ERROR, "Precompiled headers are only supported for the native build.");
+            return false;
+        }
+
+        if (config->pgo) {
+            nob_log(NOB_ERROR, "The profile guided build is only supported for the native build.");
+            return false;
+        }
     } else {
+#ifdef _WIN32
+        if (config->pgo) {
+            nob_log(NOB_ERROR, "The profile guided build needs gcc or clang.");
+            return false;
+        }
+#endif
+        if (config->pgo && (config->sdl_direct || config->unity || config->pch)) {
+            nob_log(NOB_ERROR, "The profile guided build always builds SDL with cmake and the app in one go, remove the other build flags.");
+            return false;
+        }
+
         if (config->device) {
             nob_log(NOB_ERROR, "Device flag is only supported with iOS or Android builds for mobile devices. Otherwise it builds for the respective simulator/emulator. For native build, remove the flag.");
             return false;
@@ -183,32 +270,68 @@ bool parse_config_from_args(int *argc, char ***argv, Config *config) {
     return true;
 }
 
+// the view is not NUL-terminated, so atoi() can't be used on it
+int sv_to_int(String_View sv) {
+    sv = sv_trim(sv);
+    int sign = 1;
+    if (sv.count > 0 && sv.data[0] == '-') {
+        sign = -1;
+        sv_chop_left(&sv, 1);
+    }
+    int result = 0;
+    while (sv.count > 0 && isdigit((unsigned char)sv.data[0])) {
+        result = result*10 + (sv.data[0] - '0');
+        sv_chop_left(&sv, 1);
+    }
+    return sign*result;
+}
+
+typedef struct {
+    String_View key;
+    int value;
+} Config_Value;
+
+typedef struct {
+    Config_Value *items;
+    size_t count;
+    size_t capacity;
+} Config_Values;
+
+// keys that are not in the file read as 0
+int config_value(Config_Values *values, const char *key) {
+    Config_Value *value = ht_get(values, sv_from_cstr(key));
+    return value ? value->value : 0;
+}
+
 bool load_config_from_file(const char *path, Config *config) {
     if (!file_exists(path)) {
         return false;
     }
 
-    Nob_String_Builder sb = {0};
-    if (!nob_read_entire_file(path, &sb)) return false;
+    String_View file;
+    if (!map_file(path, &file)) return false;
 
-    Nob_String_View content = sv_from_parts(sb.items, sb.count);
-    while (true) {
+    Config_Values values = {0};
+    Nob_String_View content = file;
+    while (content.count > 0) {
         Nob_String_View line = sv_chop_by_delim(&content, '\n');
         Nob_String_View key = sv_chop_by_delim(&line, '=');
-        Nob_String_View value = line;
-
-        if (nob_sv_eq(key, sv_from_cstr("optimize"))) {
-            config->optimize = atoi(value.data);
-        } else if (nob_sv_eq(key, sv_from_cstr("compiler"))) {
-            config->compiler = atoi(value.data);
-        } else if (nob_sv_eq(key, sv_from_cstr("platform"))) {
-            config->platform = atoi(value.data);
-        } else {
-            break;
-        }
+        if (key.count == 0) continue;
+        Config_Value *value = ht_put(&values, key);
+        value->value = sv_to_int(line);
     }
 
-    sb_free(sb);
+    config->optimize   = config_value(&values, "optimize");
+    config->compiler   = config_value(&values, "compiler");
+    config->platform   = config_value(&values, "platform");
+    config->device     = config_value(&values, "device");
+    config->sdl_direct = config_value(&values, "sdl_direct");
+    config->unity      = config_value(&values, "unity");
+    config->pch        = config_value(&values, "pch");
+    config->pgo        = config_value(&values, "pgo");
+
+    ht_free(values);
+    unmap_file(file);
     return true;
 }
 
@@ -222,24 +345,44 @@ char *uppercase_string(char *s) {
     return copy;
 }
 
-char *run_cmd_get_stdout(Nob_Cmd *cmd) {
-    String_Builder sb = {0};
-    Nob_Fd temp_file = fd_open_for_write(BUILD_FOLDER"/temp.txt");
-    if (!cmd_run(cmd, .fdout = &temp_file)) return NULL;
-    read_entire_file(BUILD_FOLDER"/temp.txt", &sb);
-    sb.count -= 1; // maybe bad hack? remove \n at the end
-    nob_sb_append_null(&sb);
-    return sb.items;
-}
-
-void append_cmake_build_flags(Nob_Cmd *cmd) {
+long get_jobs_count(void) {
 #ifndef _WIN32
     long jobs = sysconf(_SC_NPROCESSORS_ONLN);
 #else
     long jobs = 4;
 #endif
     if (jobs < 1) jobs = 1;
-    cmd_append(cmd, temp_sprintf("-j%ld", jobs));
+    return jobs;
+}
+
+// Whether the generator build_dir was configured with takes its job slots from nob's jobserver.
+// Only GNU make does, nmake and MSBuild ignore MAKEFLAGS and so does ninja before 1.13.
+bool cmake_generator_uses_jobserver(const char *build_dir) {
+    String_View cache;
+    if (!map_file(temp_sprintf("%s/CMakeCache.txt", build_dir), &cache)) return false;
+    String_View generator = {0};
+    String_View rest = cache;
+    while (rest.count > 0) {
+        String_View line = sv_chop_by_delim(&rest, '\n');
+        if (sv_starts_with(line, sv_from_cstr("CMAKE_GENERATOR:INTERNAL="))) {
+            generator = sv_trim(line);
+            sv_chop_by_delim(&generator, '=');
+            break;
+        }
+    }
+    bool result = sv_eq(generator, sv_from_cstr("Unix Makefiles"))
+               || sv_eq(generator, sv_from_cstr("MinGW Makefiles"))
+               || sv_eq(generator, sv_from_cstr("MSYS Makefiles"));
+    unmap_file(cache);
+    return result;
+}
+
+// builds is how many cmake builds run at the same time, they share the jobs
+void append_cmake_build_flags(Nob_Cmd *cmd, const char *build_dir, size_t builds) {
+    // make takes its job slots from nob's jobserver then, an explicit -j would make it ignore it
+    if (jobserver_active() && cmake_generator_uses_jobserver(build_dir)) return;
+    long jobs = get_jobs_count()/(long)builds;
+    cmd_append(cmd, temp_sprintf("-j%ld", jobs > 0 ? jobs : 1));
 }
 
 bool create_android_keystore(void) {
@@ -260,175 +403,335 @@ bool create_android_keystore(void) {
     return true;
 }
 
-// Building frameworks
-
-#define SDL_VERSION "3.2.16"
-#define SDL_PATH "lib/SDL-"SDL_VERSION
-#define SDL_INCLUDE "-Ilib/SDL-"SDL_VERSION"/include"
-#define SDL_FILE BUILD_FOLDER"/libsdl3_native.a"
-bool build_sdl(bool force_rebuild) {
-    const char *current_dir = get_current_dir_temp();
-
-    if (!file_exists(SDL_FILE) || force_rebuild) {
-        set_current_dir(SDL_PATH);
+// Searching for files
 
-        cmd_append(&cmd, "git", "clean", "-fdx", "build");
-        if (!cmd_run(&cmd)) goto error;
+bool allow_h_files(const char *path) {
+    size_t len = strlen(path);
+    return len > 2 && strcmp(path + len - 2, ".h") == 0;
+}
 
-        cmd_append(&cmd, "cmake", "-B", BUILD_FOLDER,
-             "-DBUILD_SHARED_LIBS=OFF",
-             "-DCMAKE_POSITION_INDEPENDENT_CODE=ON");
-#ifdef __APPLE__
-        cmd_append(&cmd, "-DCMAKE_OSX_DEPLOYMENT_TARGET="MACOS_TARGET);
-#endif
-        if (!cmd_run(&cmd)) goto error;
+bool allow_java_files(const char *path) {
+    size_t len = strlen(path);
+    return len > 5 && strcmp(path + len - 5, ".java") == 0;
+}
 
-        cmd_append(&cmd, "cmake", "--build", BUILD_FOLDER);
-        append_cmake_build_flags(&cmd);
-        if (!cmd_run(&cmd)) goto error;
+bool allow_c_source_files(const char *path) {
+    size_t len = strlen(path);
+    return len > 2 && strcmp(path + len - 2, ".c") == 0;
+}
 
-#ifdef _WIN32
-        const char *output_path = "Debug/SDL3-static.lib";
-#else
-        const char *output_path = "libSDL3.a";
-#endif
+bool allow_c_files(const char *path) {
+    size_t len = strlen(path);
+    return len > 2 && (strcmp(path + len - 2, ".c") == 0 || strcmp(path + len - 2, ".h") == 0);
+}
 
-        set_current_dir("build"); // sdl's build folder
-        if (!copy_file(output_path, "../../../"SDL_FILE)) goto error;
-        set_current_dir(current_dir);
-    }
+bool allow_all_files(const char *path) {
+    (void)path;
     return true;
-
-error:
-    set_current_dir(current_dir);
-    return false;
 }
 
-#define ANDROID_APK_FOLDER ANDROID_BUILD"/apk"
-#define SDL_ANDROID_FILE BUILD_FOLDER"/libsdl3_android.so"
-bool build_sdl_android(void) {
-    const char *current_dir = get_current_dir_temp();
-
-    if (!file_exists(SDL_ANDROID_FILE)) {
-        set_current_dir(SDL_PATH);
+// the paths are malloc'ed, the stat of every collected file is cached for the rebuild checks
+void recursively_collect_files(const char *parent, Nob_File_Paths *out, bool (*filter_function) (const char *)) {
+    walk_files(parent, out, filter_function, get_jobs_count());
+}
 
-        cmd_append(&cmd, "git", "clean", "-fdx", "build");
-        if (!cmd_run(&cmd)) goto error;
+// frees the paths of recursively_collect_files() together with the list
+void free_collected_files(Nob_File_Paths *files) {
+    da_foreach(const char*, path, files) free((char*)*path);
+    da_free(*files);
+    *files = (Nob_File_Paths){0};
+}
 
-        // TODO: someday try to build it statically for android too
-        if (env.android_ndk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_NDK_LOCATION not set"); return 1; }
-        if (env.android_sdk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_SDK_LOCATION not set"); return 1; }
+// Building frameworks
 
-        char *ndk_arg = temp_sprintf("-DCMAKE_TOOLCHAIN_FILE="SV_Fmt"/build/cmake/android.toolchain.cmake", SV_Arg(env.android_ndk_location));
-        char *api_arg = temp_sprintf("-DANDROID_PLATFORM=%d", ANDROID_API);
-        char *abi_arg = temp_sprintf("-DANDROID_ABI=%s", ANDROID_ABI);
+// creates every missing folder on the way to the file
+bool mkdir_for_file(const char *file_path) {
+    char *path = temp_strdup(file_path);
+    Nob_Log_Level level = minimal_log_level;
+    minimal_log_level = NOB_NO_LOGS;
+    bool result = true;
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (!mkdir_if_not_exists(path)) result = false;
+        *p = '/';
+        if (!result) break;
+    }
+    minimal_log_level = level;
+    return result;
+}
 
-        cmd_append(&cmd, "cmake", "-B", BUILD_FOLDER,
-            ndk_arg, api_arg, abi_arg,
-            "-DSDL_SHARED=ON",
-            "-DSDL_STATIC=OFF",
-            "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
-            // "-DCMAKE_BUILD_TYPE=Release"
-        );
-        if (!cmd_run(&cmd)) goto error;
+// deletes the file quietly, there are a lot of them
+bool delete_if_exists(const char *file_path) {
+    if (!file_exists(file_path)) return true;
+    Nob_Log_Level level = minimal_log_level;
+    minimal_log_level = NOB_WARNING;
+    bool result = delete_file(file_path);
+    minimal_log_level = level;
+    return result;
+}
 
-        cmd_append(&cmd, "cmake", "--build", BUILD_FOLDER);
-        append_cmake_build_flags(&cmd);
-        if (!cmd_run(&cmd)) goto error;
 
-        set_current_dir("build"); // sdl's build folder
-        if (!copy_file("libSDL3.so", "../../../"SDL_ANDROID_FILE)) goto error;
-        set_current_dir(current_dir);
+#define SDL_VERSION "3.2.16"
+#define SDL_PATH "lib/SDL-"SDL_VERSION
+#define SDL_INCLUDE "-Ilib/SDL-"SDL_VERSION"/include"
+#define SDL_FILE BUILD_FOLDER"/libsdl3_native.a"
+// every platform/abi keeps its own configured cmake tree here between builds
+#define SDL_BUILD_FOLDER BUILD_FOLDER"/sdl"
+// the database of the SDL tree the platform that is built uses, merged into ours by finish_compdb()
+const char *compdb_sdl_database = SDL_BUILD_FOLDER"/native/compile_commands.json";
+
+// returns 1 if any of the sdl sources is newer than the output
+int sdl_sources_changed(const char *output_path) {
+    static Nob_File_Paths sdl_inputs = {0};
+    if (sdl_inputs.count == 0) {
+        da_append(&sdl_inputs, SDL_PATH"/CMakeLists.txt");
+        recursively_collect_files(SDL_PATH"/cmake", &sdl_inputs, allow_all_files);
+        recursively_collect_files(SDL_PATH"/include", &sdl_inputs, allow_all_files);
+        recursively_collect_files(SDL_PATH"/src", &sdl_inputs, allow_all_files);
     }
-    return true;
+    return needs_rebuild(output_path, sdl_inputs.items, sdl_inputs.count);
+}
 
-error:
-    set_current_dir(current_dir);
-    return false;
+const char *sdl_built_stamp(const char *build_dir) {
+    return temp_sprintf("%s/nob_built.stamp", build_dir);
 }
 
-bool build_sdl_ios(Config *config) {
-    const char *current_dir = get_current_dir_temp();
+typedef struct {
+    const char *build_dir;
+    Nob_Cmd options;
+    const char *artifact;
+    const char *output_path;
+    // filled in by build_sdl_cmake_many()
+    Nob_String_Builder rendered_options;
+    bool configure;
+} Sdl_Cmake;
+
+// Configures sdl into each build_dir only when the cmake options differ from the ones the tree was
+// configured with, then lets cmake rebuild whatever changed and copies the artifact out. The builds
+// are independent of each other, so all of them are configured and then built at the same time.
+bool build_sdl_cmake_many(Sdl_Cmake *builds, size_t count, bool force_rebuild) {
+    bool result = true;
+    Nob_Procs procs = {0};
+    Nob_String_Builder saved_options_sb = {0};
+    bool *build = calloc(count, sizeof(*build));
+    assert(build != NULL);
+
+    for (size_t i = 0; i < count; ++i) {
+        Sdl_Cmake *it = &builds[i];
+        const char *cache_path = temp_sprintf("%s/CMakeCache.txt", it->build_dir);
+        const char *options_path = temp_sprintf("%s/nob_options.txt", it->build_dir);
+        it->rendered_options.count = 0;
+        cmd_render(it->options, &it->rendered_options);
+
+        it->configure = force_rebuild || !file_exists(cache_path) || !file_exists(options_path);
+        if (!it->configure) {
+            saved_options_sb.count = 0;
+            if (!read_entire_file(options_path, &saved_options_sb)) return_defer(false);
+            it->configure = !sv_eq(sb_to_sv(it->rendered_options), sb_to_sv(saved_options_sb));
+            if (it->configure) nob_log(NOB_INFO, "SDL options changed: %s", it->build_dir);
+        }
+        if (!it->configure) continue;
+
+        if (!mkdir_for_file(options_path)) return_defer(false);
+        // options that were removed would otherwise stick around in the cache
+        if (file_exists(cache_path) && !delete_file(cache_path)) return_defer(false);
+        // a failed configure must not look like a finished one next time
+        if (file_exists(options_path) && !delete_file(options_path)) return_defer(false);
+
+        cmd_append(&cmd, "cmake", "-S", SDL_PATH, "-B", it->build_dir);
+        cmd_extend(&cmd, &it->options);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, get_jobs_count())) return_defer(false);
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
+
+    size_t building = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Sdl_Cmake *it = &builds[i];
+        if (it->configure) {
+            const char *options_path = temp_sprintf("%s/nob_options.txt", it->build_dir);
+            if (!write_entire_file(options_path, it->rendered_options.items, it->rendered_options.count)) return_defer(false);
+        }
+        // The copy keeps the mtime of cmake's artifact, which cmake leaves alone when none of the
+        // sources it builds changed. A stamp written after the build is what the sources are checked against
+        int sources_changed = file_exists(it->output_path) ? sdl_sources_changed(sdl_built_stamp(it->build_dir)) : 1;
+        if (sources_changed < 0) return_defer(false);
+        build[i] = it->configure || sources_changed;
+        if (build[i]) building += 1;
+    }
 
-    char *platform = config->device ? "iphoneos" : "iphonesimulator";
-    char *sdl_ios_file = temp_sprintf(BUILD_FOLDER"/libsdl3_%s.a", platform);
-    char *relative_sdl_ios_file = temp_sprintf("../../../"BUILD_FOLDER"/libsdl3_%s.a", platform);
-    char *sysroot_arg = temp_sprintf("-DCMAKE_OSX_SYSROOT=%s", platform);
+    for (size_t i = 0; i < count; ++i) {
+        if (!build[i]) continue;
+        cmd_append(&cmd, "cmake", "--build", builds[i].build_dir);
+        append_cmake_build_flags(&cmd, builds[i].build_dir, building);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, building)) return_defer(false);
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
 
-    if (!file_exists(sdl_ios_file)) {
-        set_current_dir(SDL_PATH);
+    for (size_t i = 0; i < count; ++i) {
+        if (!build[i]) continue;
+        if (!copy_file(temp_sprintf("%s/%s", builds[i].build_dir, builds[i].artifact), builds[i].output_path)) return_defer(false);
+        if (!write_entire_file(sdl_built_stamp(builds[i].build_dir), NULL, 0)) return_defer(false);
+    }
 
-        cmd_append(&cmd, "git", "clean", "-fdx", "build");
-        if (!cmd_run(&cmd)) goto error;
+defer:
+    cmd.count = 0;
+    if (!procs_wait_and_reset(&procs)) result = false;
+    for (size_t i = 0; i < count; ++i) sb_free(builds[i].rendered_options);
+    sb_free(saved_options_sb);
+    free(build);
+    return result;
+}
 
-        cmd_append(&cmd, "cmake", "-B", BUILD_FOLDER,
-            "-DCMAKE_SYSTEM_NAME=iOS",
-            "-DCMAKE_OSX_ARCHITECTURES=x86_64;arm64",
-            sysroot_arg,
-            "-DSDL_SHARED=OFF",
-            "-DSDL_STATIC=ON"
-            // "-DCMAKE_BUILD_TYPE=Release",
-        );
-        if (!cmd_run(&cmd)) goto error;
+bool build_sdl_cmake(const char *build_dir, Nob_Cmd *options, const char *artifact, const char *output_path, bool force_rebuild) {
+    Sdl_Cmake build = { .build_dir = build_dir, .options = *options, .artifact = artifact, .output_path = output_path };
+    bool result = build_sdl_cmake_many(&build, 1, force_rebuild);
+    options->count = 0;
+    return result;
+}
 
-        cmd_append(&cmd, "cmake", "--build", BUILD_FOLDER);
-        if (!cmd_run(&cmd)) goto error;
+bool build_sdl(bool force_rebuild) {
+    Nob_Cmd options = {0};
+    cmd_append(&options,
+         "-DBUILD_SHARED_LIBS=OFF",
+         "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
+         // merged into the app's compile_commands.json
+         "-DCMAKE_EXPORT_COMPILE_COMMANDS=ON");
+#ifdef __APPLE__
+    cmd_append(&options, "-DCMAKE_OSX_DEPLOYMENT_TARGET="MACOS_TARGET);
+#endif
 
-        set_current_dir("build");
-        cmd_append(&cmd, "ls");
-        if (!cmd_run(&cmd)) goto error;
+#ifdef _WIN32
+    const char *artifact = "Debug/SDL3-static.lib";
+#else
+    const char *artifact = "libSDL3.a";
+#endif
 
-        if (!copy_file("libSDL3.a", relative_sdl_ios_file)) goto error;
-        set_current_dir(current_dir);
-    }
+    bool result = build_sdl_cmake(SDL_BUILD_FOLDER"/native", &options, artifact, SDL_FILE, force_rebuild);
+    cmd_free(options);
+    return result;
+}
 
-    return true;
+#define ANDROID_BUILD BUILD_FOLDER"/android"
+#define ANDROID_APK_FOLDER ANDROID_BUILD"/apk"
 
-error:
-    set_current_dir(current_dir);
-    return false;
-}
+typedef struct {
+    const char *name;     // the folder in lib/ of the apk
+    const char *target;   // the prefix of the NDK's clang
+} Android_Abi;
 
-// Searching for files
+typedef struct {
+    Android_Abi *items;
+    size_t count;
+    size_t capacity;
+} Android_Abis;
+
+Android_Abis android_abis = {0};
+
+bool parse_android_abis(void) {
+    static const Android_Abi known[] = {
+        { "arm64-v8a",   "aarch64-linux-android" },
+        { "armeabi-v7a", "armv7a-linux-androideabi" },
+        { "x86_64",      "x86_64-linux-android" },
+        { "x86",         "i686-linux-android" },
+    };
+
+    android_abis.count = 0;
+    String_View list = env.android_abis.count > 0 ? env.android_abis : sv_from_cstr(ANDROID_ABIS);
+    while (list.count > 0) {
+        String_View name = sv_trim(sv_chop_by_delim(&list, ','));
+        if (name.count == 0) continue;
 
-bool allow_h_files(const char *path) {
-    size_t len = strlen(path);
-    return len > 2 && strcmp(path + len - 2, ".h") == 0;
-}
+        size_t i = 0;
+        while (i < ARRAY_LEN(known) && !sv_eq(name, sv_from_cstr(known[i].name))) ++i;
+        if (i == ARRAY_LEN(known)) {
+            nob_log(NOB_ERROR, "Unknown Android ABI '"SV_Fmt"' in ANDROID_ABIS", SV_Arg(name));
+            return false;
+        }
 
-bool allow_java_files(const char *path) {
-    size_t len = strlen(path);
-    return len > 5 && strcmp(path + len - 5, ".java") == 0;
+        // listed twice, it would be built twice and zipped twice into the apk
+        bool listed = false;
+        for (size_t j = 0; j < android_abis.count && !listed; ++j) listed = android_abis.items[j].name == known[i].name;
+        if (listed) {
+            nob_log(NOB_WARNING, "Android ABI '"SV_Fmt"' is listed more than once in ANDROID_ABIS", SV_Arg(name));
+            continue;
+        }
+        da_append(&android_abis, known[i]);
+    }
+    if (android_abis.count == 0) {
+        nob_log(NOB_ERROR, "ANDROID_ABIS does not list any ABI");
+        return false;
+    }
+    return true;
 }
 
-bool allow_c_files(const char *path) {
-    size_t len = strlen(path);
-    return len > 2 && (strcmp(path + len - 2, ".c") == 0 || strcmp(path + len - 2, ".h") == 0);
+const char *android_sdl_file(const char *abi) {
+    return temp_sprintf(ANDROID_BUILD"/%s/libsdl3_android.so", abi);
 }
 
-bool allow_all_files(const char *path) {
-    return true;
+const char *android_libmain_file(const char *abi) {
+    return temp_sprintf(ANDROID_APK_FOLDER"/lib/%s/libmain.so", abi);
 }
 
-void recursively_collect_files(const char *parent, Nob_File_Paths *out, bool (*filter_function) (const char *)) {
-    Nob_File_Paths entries = {0};
-    if (!nob_read_entire_dir(parent, &entries)) return;
+// SDL is configured and built for all the ABIs at the same time, each in its own folder
+bool build_sdl_android(void) {
+    // TODO: someday try to build it statically for android too
+    if (env.android_ndk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_NDK_LOCATION not set"); return false; }
+    if (env.android_sdk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_SDK_LOCATION not set"); return false; }
 
-    for (size_t i = 0; i < entries.count; ++i) {
-        const char *sub = entries.items[i];
-        if (strcmp(sub, ".") == 0 || strcmp(sub, "..") == 0) continue;
-        char *path = temp_sprintf("%s/%s", parent, sub);
-        Nob_File_Type t = get_file_type(path);
+    char *ndk_arg = temp_sprintf("-DCMAKE_TOOLCHAIN_FILE="SV_Fmt"/build/cmake/android.toolchain.cmake", SV_Arg(env.android_ndk_location));
+    char *api_arg = temp_sprintf("-DANDROID_PLATFORM=%d", ANDROID_API);
 
-        if (t == NOB_FILE_DIRECTORY) {
-            recursively_collect_files(path, out, filter_function);
-        } else if (t == NOB_FILE_REGULAR) {
-            if (filter_function(path)) {
-                da_append(out, temp_strdup(path));
-            }
-        }
+    Sdl_Cmake *builds = calloc(android_abis.count, sizeof(*builds));
+    assert(builds != NULL);
+    for (size_t i = 0; i < android_abis.count; ++i) {
+        const char *abi = android_abis.items[i].name;
+        builds[i].build_dir = temp_sprintf(SDL_BUILD_FOLDER"/android-%s", abi);
+        builds[i].artifact = "libSDL3.so";
+        builds[i].output_path = android_sdl_file(abi);
+        cmd_append(&builds[i].options,
+            ndk_arg, api_arg, temp_sprintf("-DANDROID_ABI=%s", abi),
+            "-DSDL_SHARED=ON",
+            "-DSDL_STATIC=OFF",
+            "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
+            "-DCMAKE_EXPORT_COMPILE_COMMANDS=ON",
+            // "-DCMAKE_BUILD_TYPE=Release"
+        );
     }
-    da_free(entries);
+
+    // one entry per source, so clangd sees SDL the way the first ABI builds it
+    compdb_sdl_database = strdup(temp_sprintf("%s/compile_commands.json", builds[0].build_dir));
+    bool result = build_sdl_cmake_many(builds, android_abis.count, false);
+    for (size_t i = 0; i < android_abis.count; ++i) cmd_free(builds[i].options);
+    free(builds);
+    return result;
+}
+
+bool build_sdl_ios(Config *config) {
+    char *platform = config->device ? "iphoneos" : "iphonesimulator";
+    char *sdl_ios_file = temp_sprintf(BUILD_FOLDER"/libsdl3_%s.a", platform);
+    char *sysroot_arg = temp_sprintf("-DCMAKE_OSX_SYSROOT=%s", platform);
+
+    Nob_Cmd options = {0};
+    cmd_append(&options,
+        "-DCMAKE_SYSTEM_NAME=iOS",
+        "-DCMAKE_OSX_ARCHITECTURES=x86_64;arm64",
+        sysroot_arg,
+        "-DSDL_SHARED=OFF",
+        "-DSDL_STATIC=ON",
+        "-DCMAKE_EXPORT_COMPILE_COMMANDS=ON"
+        // "-DCMAKE_BUILD_TYPE=Release",
+    );
+
+    const char *build_dir = temp_sprintf(SDL_BUILD_FOLDER"/%s", platform);
+    compdb_sdl_database = strdup(temp_sprintf("%s/compile_commands.json", build_dir));
+    bool result = build_sdl_cmake(build_dir, &options, "libSDL3.a", sdl_ios_file, false);
+    cmd_free(options);
+    return result;
 }
 
 int compare_paths(const void* a, const void* b) {
@@ -511,16 +814,16 @@ void app_default_cmd(void) {
 #endif
 }
 
-void append_renderer_libraries(void) {
+void append_renderer_libraries(const char *sdl_file) {
 #ifdef __linux__
     Nob_String_Builder sb = {0};
     sb_append_cstr(&sb, "-Wl,--whole-archive,");
-    sb_append_cstr(&sb, SDL_FILE);
+    sb_append_cstr(&sb, sdl_file);
     sb_append_null(&sb);
     cmd_append(&cmd, sb.items);
     cmd_append(&cmd, "-Wl,--no-whole-archive");
 #else
-    cmd_append(&cmd, temp_sprintf("-Wl,-force_load,%s", SDL_FILE));
+    cmd_append(&cmd, temp_sprintf("-Wl,-force_load,%s", sdl_file));
 #endif
 }
 
@@ -530,8 +833,35 @@ void append_includes(void) {
 }
 
 #define SDL_JAVA_SRC SDL_PATH"/android-project/app/src/main/java/org/libsdl/app"
-#define ANDROID_BUILD BUILD_FOLDER"/android"
-bool build_app_android(void) {
+// Android stages, timed so it is visible where the turnaround goes
+
+typedef struct {
+    const char *name;
+    unsigned long long usec;
+    bool ran;             // false if the stage was up to date
+} Stage;
+
+typedef struct {
+    Stage *items;
+    size_t count;
+    size_t capacity;
+} Stages;
+
+void stage_done(Stages *stages, const char *name, unsigned long long start, bool ran) {
+    Stage stage = { .name = name, .usec = get_timestamp_usec() - start, .ran = ran };
+    da_append(stages, stage);
+}
+
+void log_stages(Stages *stages, const char *title) {
+    nob_log(NOB_INFO, "%s", title);
+    da_foreach(Stage, stage, stages) {
+        nob_log(NOB_INFO, "  %-10s %0.3fs%s", stage->name, (float)stage->usec / 1000000.0f, stage->ran ? "" : " (up to date)");
+    }
+}
+
+// Every stage runs only when the content of its inputs changed since its output was produced,
+// force reruns all of them
+bool build_app_android(bool force) {
     if (env.android_ndk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_NDK_LOCATION not set"); return 1; }
     if (env.android_sdk_location.count == 0) { nob_log(NOB_ERROR, "env ANDROID_SDK_LOCATION not set"); return 1; }
 
@@ -545,31 +875,55 @@ bool build_app_android(void) {
 #  error "Unsupported host for Android build"
 #endif
 
-    // build app (as library)
-
-    // TODO: select correct arch
-    const char *target_arch = "aarch64-linux";
-    char *compiler = temp_sprintf(SV_Fmt"/toolchains/llvm/prebuilt/%s/bin/%s-android%d-clang",
-        SV_Arg(env.android_ndk_location), host, target_arch, ANDROID_API);
-    char *api_arg = temp_sprintf("-DANDROID_PLATFORM=%d", ANDROID_API);
-    char *sdl_arg = temp_sprintf("-L"BUILD_FOLDER);
-
-    cmd_append(&cmd, compiler);
-    app_default_cmd();
-    cmd_append(&cmd, "-shared");
-    cmd_append(&cmd, "-fPIC");
-    cmd_append(&cmd, api_arg);
-    cmd_append(&cmd, SRC"/main.c");
-    append_includes();
-    cmd_append(&cmd, sdl_arg, "-lsdl3_android");
-    cmd_append(&cmd, "-llog");
-    cmd_append(&cmd, "-DRENDERER_SDL3");
-    cmd_append(&cmd, "-DOS_ANDROID");
-    cmd_append(&cmd, "-g", "-fno-omit-frame-pointer");
+    bool result = true;
+    Stages stages = {0};
+    Nob_File_Paths java_inputs = {0};
+    Nob_File_Paths sdl_java_sources = {0};
+    Nob_Procs procs = {0};
+    unsigned long long start = get_timestamp_usec();
 
-    cmd_append(&cmd, "-o");
-    cmd_append(&cmd, ANDROID_APK_FOLDER"/lib/"ANDROID_ABI"/libmain.so");
-    if (!cmd_run(&cmd)) return false;
+    // build app (as library), for all the ABIs at the same time
+    size_t rebuilt = 0;
+    for (size_t i = 0; i < android_abis.count; ++i) {
+        const Android_Abi *abi = &android_abis.items[i];
+        const char *libmain = android_libmain_file(abi->name);
+        const char *libmain_depfile = temp_sprintf(ANDROID_BUILD"/%s/libmain.d", abi->name);
+        const char *sdl = android_sdl_file(abi->name);
+        int rebuild = force ? 1 : needs_rebuild_depfile(libmain, libmain_depfile);
+        const char *libmain_inputs[] = { sdl, "nob.c" };
+        if (rebuild == 0) rebuild = needs_rebuild(libmain, libmain_inputs, ARRAY_LEN(libmain_inputs));
+        if (rebuild < 0) return_defer(false);
+        if (!rebuild) continue;
+
+        char *compiler = temp_sprintf(SV_Fmt"/toolchains/llvm/prebuilt/%s/bin/%s%d-clang",
+            SV_Arg(env.android_ndk_location), host, abi->target, ANDROID_API);
+        char *api_arg = temp_sprintf("-DANDROID_PLATFORM=%d", ANDROID_API);
+        char *sdl_arg = temp_sprintf("-L"ANDROID_BUILD"/%s", abi->name);
+
+        if (!mkdir_for_file(libmain) || !mkdir_for_file(libmain_depfile)) return_defer(false);
+        cmd_append(&cmd, compiler);
+        app_default_cmd();
+        cmd_append(&cmd, "-shared");
+        cmd_append(&cmd, "-fPIC");
+        cmd_append(&cmd, api_arg);
+        cmd_append(&cmd, SRC"/main.c");
+        append_includes();
+        cmd_append(&cmd, sdl_arg, "-lsdl3_android");
+        cmd_append(&cmd, "-llog");
+        cmd_append(&cmd, "-DRENDERER_SDL3");
+        cmd_append(&cmd, "-DOS_ANDROID");
+        cmd_append(&cmd, "-g", "-fno-omit-frame-pointer");
+        nob_cc_depfile(&cmd, libmain_depfile);
+
+        cmd_append(&cmd, "-o");
+        cmd_append(&cmd, libmain);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, get_jobs_count())) return_defer(false);
+        rebuilt += 1;
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
+    stage_done(&stages, "native", start, rebuilt > 0);
 
     // build java activity
     if (env.android_java_home.count == 0) {
@@ -580,7 +934,7 @@ bool build_app_android(void) {
 #elif __APPLE__
         nob_log(NOB_INFO, "/Library/Java/JavaVirtualMachines/jdk-{ver}.jdk/Contents/Home");
 #endif
-        return false;
+        return_defer(false);
     }
 
     const char *android_jar = temp_sprintf(SV_Fmt"/platforms/android-%d/android.jar", SV_Arg(env.android_sdk_location), ANDROID_API);
@@ -591,81 +945,116 @@ bool build_app_android(void) {
         nob_log(NOB_INFO, "Available platforms:");
         const char *platforms_folder = temp_sprintf(SV_Fmt"/platforms", SV_Arg(env.android_sdk_location));
         cmd_append(&cmd, "ls", platforms_folder);
-        if (!cmd_run(&cmd)) return false;
+        if (!cmd_run(&cmd)) return_defer(false);
 
-        return false;
+        return_defer(false);
     }
 
-    cmd_append(&cmd, "javac");
-    cmd_append(&cmd, "-classpath");
-    cmd_append(&cmd, android_jar);
-    cmd_append(&cmd, "-d", ANDROID_BUILD"/java");
-    cmd_append(&cmd, "android/MainActivity.java");
-
-    Nob_File_Paths sdl_java_files = {0};
-    recursively_collect_files(SDL_JAVA_SRC, &sdl_java_files, allow_java_files);
-    da_foreach(const char*, java_file, &sdl_java_files) {
-        cmd_append(&cmd, *java_file);
+    // build .class, .jar, .dex
+    start = get_timestamp_usec();
+    da_append(&java_inputs, "android/MainActivity.java");
+    recursively_collect_files(SDL_JAVA_SRC, &sdl_java_sources, allow_java_files);
+    da_append_many(&java_inputs, sdl_java_sources.items, sdl_java_sources.count);
+    size_t java_sources = java_inputs.count;
+    da_append(&java_inputs, android_jar);
+    da_append(&java_inputs, "nob.c");
+    int rebuild = force ? 1 : needs_rebuild(ANDROID_APK_FOLDER"/classes.dex", java_inputs.items, java_inputs.count);
+    if (rebuild < 0) return_defer(false);
+    if (rebuild) {
+        // classes of deleted sources must not end up in the jar
+        cmd_append(&cmd, "rm", "-rf", ANDROID_BUILD"/java");
+        if (!cmd_run(&cmd)) return_defer(false);
+        if (!mkdir_if_not_exists(ANDROID_BUILD"/java")) return_defer(false);
+
+        cmd_append(&cmd, "javac");
+        cmd_append(&cmd, "-classpath");
+        cmd_append(&cmd, android_jar);
+        cmd_append(&cmd, "-d", ANDROID_BUILD"/java");
+        da_append_many(&cmd, java_inputs.items, java_sources);
+        if (!cmd_run(&cmd)) return_defer(false);
+
+        cmd_append(&cmd, "jar", "cf", ANDROID_BUILD"/app.jar", "-C", ANDROID_BUILD"/java", ".");
+        if (!cmd_run(&cmd)) return_defer(false);
+
+        const char *d8 = temp_sprintf(SV_Fmt"/build-tools/%s/d8", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
+        cmd_append(&cmd, d8,  "--output", ANDROID_APK_FOLDER, ANDROID_BUILD"/app.jar"); // TODO: at some point we will want to add "--release"
+        if (!cmd_run(&cmd)) return_defer(false);
     }
-    if (!cmd_run(&cmd)) return false;
-
-    // build .jar, .dex
-
-    cmd_append(&cmd, "jar", "cf", ANDROID_BUILD"/app.jar", "-C", ANDROID_BUILD"/java", ".");
-    if (!cmd_run(&cmd)) return false;
-
-    const char *d8 = temp_sprintf(SV_Fmt"/build-tools/%s/d8", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
-    cmd_append(&cmd, d8,  "--output", ANDROID_BUILD"/apk", ANDROID_BUILD"/app.jar"); // TODO: at some point we will want to add "--release"
-    if (!cmd_run(&cmd)) return false;
-
-    // build unsigned apk using manifest
-    const char *aapt2 = temp_sprintf(SV_Fmt"/build-tools/%s/aapt2", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
-    cmd_append(&cmd, aapt2);
-    cmd_append(&cmd, "link");
-    cmd_append(&cmd, "-o", ANDROID_BUILD"/app-unsigned.apk");
-    cmd_append(&cmd, "--manifest", "android/AndroidManifest.xml");
-    cmd_append(&cmd, "-I", android_jar);
-    cmd_append(&cmd, "--version-code", "1");
-    cmd_append(&cmd, "--version-name", "1.0");
-    if (!cmd_run(&cmd)) return false;
-
-    // add files to apk
-    if (!copy_file(SDL_ANDROID_FILE, ANDROID_APK_FOLDER"/lib/"ANDROID_ABI"/libsdl3_android.so")) return false;
-    cmd_append(&cmd, "zip", "-g", "-j", ANDROID_BUILD"/app-unsigned.apk", ANDROID_BUILD"/apk/classes.dex");
-    if (!cmd_run(&cmd)) return false;
-
-    set_current_dir(ANDROID_APK_FOLDER);
-    cmd_append(&cmd, "zip", "-g", "-r", "../app-unsigned.apk", "lib/");
-    if (!cmd_run(&cmd)) return false;
-    set_current_dir("../../..");
-
-    // align .apk
-    const char *zipalign = temp_sprintf(SV_Fmt"/build-tools/%s/zipalign", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
-    cmd_append(&cmd, zipalign, "-v", "4", ANDROID_BUILD"/app-unsigned.apk", ANDROID_BUILD"/app-aligned.apk");
-    if (!cmd_run(&cmd)) return false;
+    stage_done(&stages, "java", start, rebuild);
+
+    // compile the resources and the manifest
+    start = get_timestamp_usec();
+    const char *resources_inputs[] = { "android/AndroidManifest.xml", android_jar, "nob.c" };
+    rebuild = force ? 1 : needs_rebuild(ANDROID_BUILD"/resources.apk", resources_inputs, ARRAY_LEN(resources_inputs));
+    if (rebuild < 0) return_defer(false);
+    if (rebuild) {
+        const char *aapt2 = temp_sprintf(SV_Fmt"/build-tools/%s/aapt2", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
+        cmd_append(&cmd, aapt2);
+        cmd_append(&cmd, "link");
+        cmd_append(&cmd, "-o", ANDROID_BUILD"/resources.apk");
+        cmd_append(&cmd, "--manifest", "android/AndroidManifest.xml");
+        cmd_append(&cmd, "-I", android_jar);
+        cmd_append(&cmd, "--version-code", "1");
+        cmd_append(&cmd, "--version-name", "1.0");
+        if (!cmd_run(&cmd)) return_defer(false);
+    }
+    stage_done(&stages, "resources", start, rebuild);
+
+    // assemble the aligned apk, entries that did not change since the last build stay where they are
+    start = get_timestamp_usec();
+    Zip apk = {0};
+    if (!zip_open(&apk, ANDROID_BUILD"/app-unsigned.apk")) return_defer(false);
+    bool assembled = zip_add_zip(&apk, ANDROID_BUILD"/resources.apk")
+        && zip_add_file(&apk, "classes.dex", ANDROID_APK_FOLDER"/classes.dex", 4);
+    for (size_t i = 0; assembled && i < android_abis.count; ++i) {
+        const char *abi = android_abis.items[i].name;
+        assembled = zip_add_file(&apk, temp_sprintf("lib/%s/libmain.so", abi), android_libmain_file(abi), ANDROID_PAGE_SIZE)
+                 && zip_add_file(&apk, temp_sprintf("lib/%s/libsdl3_android.so", abi), android_sdl_file(abi), ANDROID_PAGE_SIZE);
+    }
+    // after a failed add the apk is deleted rather than finished with broken entries
+    if (!zip_close(&apk) || !assembled) return_defer(false);
+    nob_log(NOB_INFO, "Wrote %zu entries of the apk, %zu were unchanged.", apk.written, apk.kept);
+    stage_done(&stages, "apk", start, apk.changed);
 
     // sign .apk
-    const char *apksigner = temp_sprintf(SV_Fmt"/build-tools/%s/apksigner", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
-    cmd_append(&cmd, apksigner);
-    cmd_append(&cmd, "sign");
-    cmd_append(&cmd, "--ks", ANDROID_KEYSTORE_FILE);
-    cmd_append(&cmd, "--ks-pass", "pass:android");
-    cmd_append(&cmd, "--key-pass", "pass:android");
-    cmd_append(&cmd, "--out", ANDROID_BUILD"/app.apk");
-    cmd_append(&cmd, ANDROID_BUILD"/app-aligned.apk");
-    if (!cmd_run(&cmd)) return false;
-
-    return true;
+    start = get_timestamp_usec();
+    const char *sign_inputs[] = { ANDROID_BUILD"/app-unsigned.apk", ANDROID_KEYSTORE_FILE };
+    rebuild = force ? 1 : needs_rebuild(ANDROID_BUILD"/app.apk", sign_inputs, ARRAY_LEN(sign_inputs));
+    if (rebuild < 0) return_defer(false);
+    if (rebuild) {
+        const char *apksigner = temp_sprintf(SV_Fmt"/build-tools/%s/apksigner", SV_Arg(env.android_sdk_location), ANDROID_TOOLS);
+        cmd_append(&cmd, apksigner);
+        cmd_append(&cmd, "sign");
+        cmd_append(&cmd, "--ks", ANDROID_KEYSTORE_FILE);
+        cmd_append(&cmd, "--ks-pass", "pass:android");
+        cmd_append(&cmd, "--key-pass", "pass:android");
+        cmd_append(&cmd, "--out", ANDROID_BUILD"/app.apk");
+        cmd_append(&cmd, ANDROID_BUILD"/app-unsigned.apk");
+        if (!cmd_run(&cmd)) return_defer(false);
+    }
+    stage_done(&stages, "sign", start, rebuild);
+
+defer:
+    if (!procs_wait_and_reset(&procs)) result = false;
+    log_stages(&stages, "Android stages:");
+    da_free(stages);
+    da_free(java_inputs);
+    free_collected_files(&sdl_java_sources);
+    return result;
 }
 
 #define IOS_BUILD BUILD_FOLDER"/ios"
 #define IOS_APP_BUNDLE IOS_BUILD"/Player.app"
-bool build_app_ios(void) {
+// the sdk path is queried while SDL builds
+bool start_ios_sdk_path_query(Nob_Capture *query) {
     char *platform = config.device ? "iphoneos" : "iphonesimulator";
-    char *sdl_ios_file = temp_sprintf(BUILD_FOLDER"/libsdl3_%s.a", platform);
-
     cmd_append(&cmd, "xcrun", "--sdk", platform, "--show-sdk-path");
-    char *ios_sdk_path = run_cmd_get_stdout(&cmd);
+    return capture_start(&cmd, false, query);
+}
+
+bool build_app_ios(const char *ios_sdk_path) {
+    char *platform = config.device ? "iphoneos" : "iphonesimulator";
+    char *sdl_ios_file = temp_sprintf(BUILD_FOLDER"/libsdl3_%s.a", platform);
 
     // compile main.c
     char *arch = "arm64";
@@ -751,20 +1140,1216 @@ bool build_app_ios(void) {
     return true;
 }
 
-bool build_app_native(void) {
+#define OBJ_FOLDER BUILD_FOLDER"/obj"
+
+// (build/obj, src/foo/bar.c) -> build/obj/src/foo/bar.o
+// sources that were generated inside of the folder get their object next to them
+char *object_path_in(const char *folder, const char *source_path) {
+    size_t len = strlen(source_path);
+    if (len > 2 && strcmp(source_path + len - 2, ".c") == 0) len -= 2;
+    if (sv_starts_with(sv_from_cstr(source_path), sv_from_cstr(temp_sprintf("%s/", folder)))) {
+        return temp_sprintf("%.*s.o", (int)len, source_path);
+    }
+    return temp_sprintf("%s/%.*s.o", folder, (int)len, source_path);
+}
+
+char *object_path_for_source(const char *source_path) {
+    return object_path_in(OBJ_FOLDER, source_path);
+}
+
+// build/obj/src/main.o -> build/obj/src/main.d
+char *depfile_path_for_object(const char *object_path) {
+    return temp_sprintf("%.*s.d", (int)strlen(object_path) - 2, object_path);
+}
+
+// umbrella header that is precompiled and force-included into every app source with -pch
+#define APP_PCH_HEADER SRC"/pch.h"
+#define PCH_FOLDER     BUILD_FOLDER"/pch"
+// gcc looks for pch.h.gch next to the pch.h it is told to include, which is a stub that includes
+// the real header, so a precompiled header gcc can't use falls back to parsing it
+#define PCH_STUB       PCH_FOLDER"/pch.h"
+#define PCH_FLAGS      PCH_FOLDER"/flags.txt"
+
+const char *pch_output_path(void) {
+    return config.compiler == CLANG ? PCH_STUB".pch" : PCH_STUB".gch";
+}
+
+// flags that the precompiled header has to be built with as well
+void app_compile_flags(void) {
     app_compiler();
     app_default_cmd();
-    cmd_append(&cmd, SRC"/main.c");
     append_includes();
-    append_renderer_libraries();
     cmd_append(&cmd, "-DRENDERER_SDL3");
-    append_frameworks();
-    cmd_append(&cmd, "-o", EXE_NAME);
-    if (!cmd_run(&cmd)) return false;
-    return true;
 }
 
-// Main
+void app_compile_cmd(void) {
+    app_compile_flags();
+    if (config.pch) {
+        if (config.compiler == CLANG) {
+            cmd_append(&cmd, "-include-pch", pch_output_path());
+        } else {
+            cmd_append(&cmd, "-Winvalid-pch", "-include", PCH_STUB);
+        }
+    }
+}
+
+// The preprocessor always includes the header itself, so the build cache is keyed by the
+// contents of the headers and not by the path of the precompiled header.
+void app_preprocess_cmd(void) {
+    app_compile_flags();
+    if (config.pch) cmd_append(&cmd, "-include", APP_PCH_HEADER);
+}
+
+// Unity builds
+
+// Amalgamates sources into a few translation units that #include them, so the headers they
+// share are parsed once per batch instead of once per file.
+#define UNITY_MAX_BATCH 32
+
+// returns 1 if the file at path does not contain exactly content, 0 if it does
+int file_content_differs(const char *path, String_View content) {
+    if (!file_exists(path)) return 1;
+    String_View file;
+    if (!map_file(path, &file)) return -1;
+    int result = !sv_eq(file, content);
+    unmap_file(file);
+    return result;
+}
+
+typedef struct {
+    const char *name;
+    size_t file;
+} Local_Symbol;
+
+typedef struct {
+    Local_Symbol *items;
+    size_t count;
+    size_t capacity;
+} Local_Symbols;
+
+int compare_local_symbols(const void *a, const void *b) {
+    return strcmp(((const Local_Symbol*)a)->name, ((const Local_Symbol*)b)->name);
+}
+
+bool is_identifier_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// the identifier that ends right before the end of line
+String_View last_identifier(String_View line) {
+    while (line.count > 0 && isspace((unsigned char)line.data[line.count - 1])) line.count -= 1;
+    size_t end = line.count;
+    while (line.count > 0 && is_identifier_char(line.data[line.count - 1])) line.count -= 1;
+    return sv_from_parts(line.data + line.count, end - line.count);
+}
+
+// a header without an include guard can't be included twice by the same batch
+bool header_has_include_guard(const char *path) {
+    Nob_String_Builder sb = {0};
+    if (!read_entire_file(path, &sb)) return true;
+    String_View content = sb_to_sv(sb);
+    bool result = false;
+    while (content.count > 0) {
+        String_View line = sv_trim_left(sv_chop_by_delim(&content, '\n'));
+        if (!sv_starts_with(line, sv_from_cstr("#"))) continue;
+        if (sv_starts_with(line, sv_from_cstr("#include"))) continue;
+        // the first directive after the includes decides
+        result = sv_starts_with(line, sv_from_cstr("#ifndef")) || sv_starts_with(line, sv_from_cstr("#pragma once"));
+        break;
+    }
+    sb_free(sb);
+    return result;
+}
+
+// Collects the names a source file defines for itself at file scope: statics, macros, typedefs
+// and struct tags, plus the unguarded headers it includes. It only looks at declarations starting
+// in the first column, which is how both SDL and the app are written; anything it misses is
+// caught when the batch fails to compile.
+// Returns false if the file defines macros before its first include, since those configure the
+// system headers and would be too late inside of a batch.
+bool collect_local_symbols(const char *path, String_View content, size_t file, Local_Symbols *symbols) {
+    String_View dir = sv_from_cstr(path);
+    while (dir.count > 0 && dir.data[dir.count - 1] != '/') dir.count -= 1;
+
+    bool seen_include = false;
+    // static const double
+    // one = 1.0,
+    // two = 2.0;
+    bool in_declarators = false;
+    while (content.count > 0) {
+        String_View line = sv_chop_by_delim(&content, '\n');
+        String_View name = {0};
+
+        if (in_declarators) {
+            String_View rest = sv_trim_left(line);
+            size_t n = 0;
+            while (n < rest.count && is_identifier_char(rest.data[n])) n += 1;
+            String_View after = sv_trim_left(sv_from_parts(rest.data + n, rest.count - n));
+            if (n > 0 && after.count > 0 && strchr("(=[", after.data[0]) != NULL) {
+                name = sv_from_parts(rest.data, n);
+            }
+            for (size_t i = 0; i < line.count; ++i) {
+                if (line.data[i] == ';' || line.data[i] == '{' || line.data[i] == '(') in_declarators = false;
+            }
+        } else if (sv_starts_with(line, sv_from_cstr("#include \""))) {
+            seen_include = true;
+            sv_chop_by_delim(&line, '"');
+            String_View header = sv_chop_by_delim(&line, '"');
+            const char *header_path = temp_sprintf(SV_Fmt SV_Fmt, SV_Arg(dir), SV_Arg(header));
+            if (file_exists(header_path) == 1 && !header_has_include_guard(header_path)) {
+                name = sv_from_cstr(header_path);
+            }
+        } else if (sv_starts_with(line, sv_from_cstr("#include"))) {
+            seen_include = true;
+        } else if (sv_starts_with(line, sv_from_cstr("#define "))) {
+            if (!seen_include) return false;
+            sv_chop_left(&line, strlen("#define "));
+            line = sv_trim_left(line);
+            size_t n = 0;
+            while (n < line.count && is_identifier_char(line.data[n])) n += 1;
+            name = sv_from_parts(line.data, n);
+        } else if (sv_starts_with(line, sv_from_cstr("#undef "))) {
+            // a macro that is undefined again does not leak into the rest of the batch
+            sv_chop_left(&line, strlen("#undef "));
+            String_View undefined = sv_trim(line);
+            const char *key = temp_sprintf(SV_Fmt"|"SV_Fmt, SV_Arg(dir), SV_Arg(undefined));
+            for (size_t i = symbols->count; i > 0; --i) {
+                if (symbols->items[i - 1].file != file) break;
+                if (strcmp(symbols->items[i - 1].name, key) == 0) {
+                    symbols->items[i - 1] = symbols->items[--symbols->count];
+                    break;
+                }
+            }
+        } else if (sv_starts_with(line, sv_from_cstr("static ")) || sv_starts_with(line, sv_from_cstr("typedef "))) {
+            // the declared name is right before the first of these
+            size_t n = 0;
+            while (n < line.count && strchr("(=[;{", line.data[n]) == NULL) n += 1;
+            if (n == line.count) {
+                in_declarators = sv_starts_with(line, sv_from_cstr("static "));
+                continue;
+            }
+            if (line.data[n] == '{') continue;
+            if (line.data[n] == '(' && sv_starts_with(line, sv_from_cstr("typedef "))) {
+                // typedef int (SDLCALL *Name)(...);
+                String_View rest = sv_from_parts(line.data + n, line.count - n);
+                sv_chop_by_delim(&rest, '*');
+                rest = sv_trim_left(rest);
+                size_t len = 0;
+                while (len < rest.count && is_identifier_char(rest.data[len])) len += 1;
+                name = sv_from_parts(rest.data, len);
+            } else {
+                name = last_identifier(sv_from_parts(line.data, n));
+            }
+        } else if (sv_starts_with(line, sv_from_cstr("} ")) && sv_end_with(sv_trim_right(line), ";")) {
+            // } Name; closing a typedef
+            String_View rest = sv_trim_right(line);
+            name = last_identifier(sv_from_parts(rest.data, rest.count - 1));
+        } else if (sv_starts_with(line, sv_from_cstr("struct ")) || sv_starts_with(line, sv_from_cstr("enum "))) {
+            String_View keyword = sv_chop_by_delim(&line, ' ');
+            line = sv_trim_left(line);
+            size_t n = 0;
+            while (n < line.count && is_identifier_char(line.data[n])) n += 1;
+            String_View rest = sv_trim_left(sv_from_parts(line.data + n, line.count - n));
+            if (n == 0 || rest.count == 0 || rest.data[0] != '{') continue;
+            name = sv_from_cstr(temp_sprintf(SV_Fmt" %.*s", SV_Arg(keyword), (int)n, line.data));
+        }
+
+        if (name.count == 0) continue;
+        // batches never span folders, so only names within the same folder can collide
+        Local_Symbol symbol = { .name = temp_sprintf(SV_Fmt"|"SV_Fmt, SV_Arg(dir), SV_Arg(name)), .file = file };
+        da_append(symbols, symbol);
+    }
+    return true;
+}
+
+// Replaces sources with unity translation units generated into folder, sized to the number
+// of jobs. Files that would collide with each other inside of a batch, and the files listed
+// in folder/excluded.txt, are kept as they are and compiled on their own.
+bool unity_batch_sources(Nob_File_Paths *sources, const char *folder) {
+    bool result = true;
+    Local_Symbols symbols = {0};
+    Nob_String_Builder sb = {0};
+    Nob_File_Paths batched = {0};
+    Nob_File_Paths separate = {0};
+    bool *excluded = calloc(sources->count, sizeof(*excluded));
+    assert(excluded != NULL);
+
+    const char *excluded_path = temp_sprintf("%s/excluded.txt", folder);
+    if (file_exists(excluded_path)) {
+        if (!read_entire_file(excluded_path, &sb)) return_defer(false);
+        String_View content = sb_to_sv(sb);
+        while (content.count > 0) {
+            String_View line = sv_chop_by_delim(&content, '\n');
+            for (size_t i = 0; i < sources->count; ++i) {
+                if (sv_eq(line, sv_from_cstr(sources->items[i]))) excluded[i] = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sources->count; ++i) {
+        if (excluded[i]) continue;
+        sb.count = 0;
+        if (!read_entire_file(sources->items[i], &sb)) return_defer(false);
+        if (!collect_local_symbols(sources->items[i], sb_to_sv(sb), i, &symbols)) excluded[i] = true;
+    }
+
+    // the same name defined by two different files means neither of them can be batched
+    qsort(symbols.items, symbols.count, sizeof(*symbols.items), compare_local_symbols);
+    for (size_t i = 1; i < symbols.count; ++i) {
+        Local_Symbol *a = &symbols.items[i - 1];
+        Local_Symbol *b = &symbols.items[i];
+        if (a->file != b->file && strcmp(a->name, b->name) == 0) {
+            excluded[a->file] = true;
+            excluded[b->file] = true;
+        }
+    }
+
+    for (size_t i = 0; i < sources->count; ++i) {
+        da_append(excluded[i] ? &separate : &batched, sources->items[i]);
+    }
+
+    size_t jobs = get_jobs_count();
+    size_t batch_size = (batched.count + jobs - 1) / jobs;
+    if (batch_size > UNITY_MAX_BATCH) batch_size = UNITY_MAX_BATCH;
+    if (batch_size < 2) batch_size = 2;
+
+    // the includes are resolved relative to the generated file
+    Nob_String_Builder up = {0};
+    for (const char *p = folder; *p; ++p) {
+        if (*p == '/') sb_append_cstr(&up, "../");
+    }
+    sb_append_cstr(&up, "../");
+    sb_append_null(&up);
+
+    sources->count = 0;
+    if (!mkdir_for_file(excluded_path)) return_defer(false);
+
+    // Files are batched with the other files of their folder only, since those share the most
+    // headers. Different backends also tend to use the same names for their private types.
+    size_t batch_count = 0;
+    size_t batched_files = 0;
+    for (size_t group = 0; group < batched.count;) {
+        String_View dir = sv_from_cstr(batched.items[group]);
+        while (dir.count > 0 && dir.data[dir.count - 1] != '/') dir.count -= 1;
+        size_t group_end = group + 1;
+        while (group_end < batched.count && sv_starts_with(sv_from_cstr(batched.items[group_end]), dir)
+               && strchr(batched.items[group_end] + dir.count, '/') == NULL) {
+            group_end += 1;
+        }
+
+        size_t count = group_end - group;
+        if (count == 1) {
+            da_append(&separate, batched.items[group]);
+            group = group_end;
+            continue;
+        }
+
+        batched_files += count;
+        size_t batches = (count + batch_size - 1) / batch_size;
+        for (size_t batch = 0; batch < batches; ++batch) {
+            size_t begin = group + batch * count / batches;
+            size_t end = group + (batch + 1) * count / batches;
+
+            sb.count = 0;
+            sb_append_cstr(&sb, "// generated by nob.c\n");
+            for (size_t i = begin; i < end; ++i) {
+                sb_append_cstr(&sb, temp_sprintf("#include \"%s%s\"\n", up.items, batched.items[i]));
+            }
+
+            const char *path = temp_sprintf("%s/unity_%zu.c", folder, batch_count++);
+            // rewriting an unchanged batch would make it look newer than its object
+            int differs = file_content_differs(path, sb_to_sv(sb));
+            if (differs < 0) return_defer(false);
+            if (differs && !write_entire_file(path, sb.items, sb.count)) return_defer(false);
+            da_append(sources, path);
+        }
+        group = group_end;
+    }
+    da_append_many(sources, separate.items, separate.count);
+    sb_free(up);
+
+    nob_log(NOB_INFO, "Unity build: %zu files in %zu batches, %zu compiled separately.",
+            batched_files, batch_count, separate.count);
+
+defer:
+    free(excluded);
+    da_free(symbols);
+    da_free(batched);
+    da_free(separate);
+    sb_free(sb);
+    return result;
+}
+
+// Moves the files of a unity batch that failed to compile to folder/excluded.txt, so the next
+// time they are compiled on their own.
+bool unity_exclude_batch(const char *batch_path, const char *folder) {
+    Nob_String_Builder batch = {0};
+    Nob_String_Builder excluded = {0};
+    const char *excluded_path = temp_sprintf("%s/excluded.txt", folder);
+
+    if (!read_entire_file(batch_path, &batch)) return false;
+    if (file_exists(excluded_path) && !read_entire_file(excluded_path, &excluded)) return false;
+
+    String_View content = sb_to_sv(batch);
+    while (content.count > 0) {
+        String_View line = sv_chop_by_delim(&content, '\n');
+        if (!sv_starts_with(line, sv_from_cstr("#include \""))) continue;
+        // strip the quotes and the ../ leading back to the project root
+        sv_chop_by_delim(&line, '"');
+        line = sv_chop_by_delim(&line, '"');
+        while (sv_starts_with(line, sv_from_cstr("../"))) sv_chop_left(&line, 3);
+        sb_append_buf(&excluded, line.data, line.count);
+        sb_append_cstr(&excluded, "\n");
+    }
+
+    bool result = write_entire_file(excluded_path, excluded.items, excluded.count);
+    sb_free(batch);
+    sb_free(excluded);
+    return result;
+}
+
+// Precompiles APP_PCH_HEADER with the flags of the app when it, any header it includes, or the
+// flags changed since the last build. Returns 1 if it was rebuilt, 0 if not and -1 on error.
+int build_pch(bool force_rebuild) {
+    int result = 0;
+    Nob_String_Builder flags = {0};
+    const char *output = pch_output_path();
+    const char *depfile = temp_sprintf("%s.d", output);
+
+    app_compile_flags();
+    cmd_render(cmd, &flags);
+    cmd.count = 0;
+
+    if (!force_rebuild) {
+        int rebuild = file_content_differs(PCH_FLAGS, sb_to_sv(flags));
+        if (rebuild == 0) rebuild = needs_rebuild_depfile(output, depfile);
+        if (rebuild < 0) return_defer(-1);
+        if (rebuild == 0) return_defer(0);
+    }
+
+    if (!mkdir_for_file(PCH_STUB)) return_defer(-1);
+    const char *stub = "#include \"../../"APP_PCH_HEADER"\"\n";
+    int differs = file_content_differs(PCH_STUB, sv_from_cstr(stub));
+    if (differs < 0) return_defer(-1);
+    if (differs && !write_entire_file(PCH_STUB, stub, strlen(stub))) return_defer(-1);
+
+    app_compile_flags();
+    nob_cc_depfile(&cmd, depfile);
+    cmd_append(&cmd, "-x", "c-header", APP_PCH_HEADER, "-o", output);
+    if (!cmd_run(&cmd)) return_defer(-1);
+    if (!write_entire_file(PCH_FLAGS, flags.items, flags.count)) return_defer(-1);
+    result = 1;
+
+defer:
+    cmd.count = 0;
+    sb_free(flags);
+    return result;
+}
+
+bool link_app_native(Nob_File_Paths objects) {
+    app_compiler();
+    app_default_cmd();
+    da_append_many(&cmd, objects.items, objects.count);
+    append_renderer_libraries(SDL_FILE);
+    append_frameworks();
+    cmd_append(&cmd, "-o", EXE_NAME);
+    return cmd_run(&cmd);
+}
+
+bool build_app_native(bool force_rebuild, bool unity) {
+    // the unity batches replace the collected paths in sources, so they are freed from here
+    Nob_File_Paths collected = {0};
+    recursively_collect_files(SRC, &collected, allow_c_source_files);
+    qsort(collected.items, collected.count, sizeof(*collected.items), compare_paths);
+    Nob_File_Paths sources = {0};
+    da_append_many(&sources, collected.items, collected.count);
+
+    Nob_File_Paths objects = {0};
+    Nob_File_Paths stale = {0};
+    Nob_File_Paths missed = {0};
+    Nob_Procs procs = {0};
+    uint64_t *keys = NULL;
+    size_t jobs = get_jobs_count();
+    bool result = true;
+
+    if (unity && !unity_batch_sources(&sources, OBJ_FOLDER"/unity")) return_defer(false);
+
+    if (config.pch) {
+        // every object was compiled against the old precompiled header
+        int rebuilt = build_pch(force_rebuild);
+        if (rebuilt < 0) return_defer(false);
+        if (rebuilt) force_rebuild = true;
+    }
+
+    da_foreach(const char*, source, &sources) {
+        char *object = object_path_for_source(*source);
+        da_append(&objects, object);
+
+        // the depfile lists the source and every header it actually includes
+        int rebuild = needs_rebuild_depfile(object, depfile_path_for_object(object));
+        if (rebuild == 0) rebuild = needs_rebuild1(object, "nob.c");
+        if (rebuild < 0) return_defer(false);
+        if (!force_rebuild && rebuild == 0) continue;
+
+        if (!mkdir_for_file(object)) return_defer(false);
+        da_append(&stale, *source);
+    }
+
+    // preprocess the stale sources, the output is what the build cache is keyed by
+    da_foreach(const char*, source, &stale) {
+        const char *object = object_path_for_source(*source);
+        Nob_Fd preprocessed = fd_open_for_write(temp_sprintf("%s.i", object));
+        if (preprocessed == INVALID_FD) return_defer(false);
+
+        app_preprocess_cmd();
+        cmd_append(&cmd, "-E", *source);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, &preprocessed, NULL);
+        cmd.count = 0;
+        fd_close(preprocessed);
+        if (!procs_append_with_flush(&procs, proc, jobs)) return_defer(false);
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
+
+    keys = malloc(stale.count * sizeof(*keys));
+    assert(keys != NULL);
+    for (size_t i = 0; i < stale.count; ++i) {
+        const char *source = stale.items[i];
+        const char *object = object_path_for_source(source);
+        const char *depfile = depfile_path_for_object(object);
+        const char *preprocessed = temp_sprintf("%s.i", object);
+
+        app_compile_cmd();
+        nob_cc_depfile(&cmd, depfile);
+        cmd_append(&cmd, "-c", source);
+        cmd_append(&cmd, "-o", object);
+
+        bool ok = cache_key(cmd, preprocessed, &keys[i]);
+        if (!delete_file(preprocessed) || !ok) return_defer(false);
+
+        const char *outputs[] = { object, depfile };
+        int hit = cache_fetch(keys[i], outputs, ARRAY_LEN(outputs));
+        if (hit < 0) return_defer(false);
+        if (hit) {
+            nob_log(NOB_INFO, "Cache hit: %s", source);
+            compdb_record(cmd);
+            cmd.count = 0;
+            continue;
+        }
+
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, jobs)) return_defer(false);
+        keys[missed.count] = keys[i];
+        da_append(&missed, source);
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
+
+    for (size_t i = 0; i < missed.count; ++i) {
+        const char *object = object_path_for_source(missed.items[i]);
+        const char *outputs[] = { object, depfile_path_for_object(object) };
+        if (!cache_store(keys[i], outputs, ARRAY_LEN(outputs))) return_defer(false);
+    }
+
+    da_append(&objects, SDL_FILE);
+    int relink = needs_rebuild(EXE_NAME, objects.items, objects.count);
+    objects.count -= 1;
+    if (relink < 0) return_defer(false);
+
+    if (stale.count == 0 && relink == 0) {
+        nob_log(NOB_INFO, "Executable is up to date.");
+        return_defer(true);
+    }
+    nob_log(NOB_INFO, "Compiled %zu of %zu files.", missed.count, sources.count);
+    if (!link_app_native(objects)) return_defer(false);
+
+defer:
+    cmd.count = 0;
+    free(keys);
+    da_free(procs);
+    da_free(missed);
+    da_free(stale);
+    da_free(objects);
+    da_free(sources);
+    free_collected_files(&collected);
+    return result;
+}
+
+// Profile guided release build
+
+// Builds the app and SDL instrumented, runs the app headlessly for a fixed number of frames on the
+// offscreen video driver, and then builds both again with -flto using the recorded profile.
+// It needs gcc or clang and setenv(), so it is left out on Windows.
+#ifndef _WIN32
+#define PGO_FOLDER          BUILD_FOLDER"/pgo"
+#define PGO_OBJ_FOLDER      PGO_FOLDER"/obj"
+#define PGO_PROFILE_FOLDER  PGO_FOLDER"/profile"
+#define PGO_PROFDATA        PGO_FOLDER"/merged.profdata"
+#define PGO_SDL_FILE        PGO_FOLDER"/libsdl3.a"
+#define PGO_TRAINING_FRAMES "600"
+
+typedef enum {
+    PGO_GENERATE,
+    PGO_USE,
+} Pgo_Stage;
+
+// the profile is written to and read from absolute paths, since cmake runs the compiler in its own folder
+void append_pgo_flags(Nob_Cmd *cmd, Pgo_Stage stage) {
+    const char *profile = temp_sprintf("%s/"PGO_PROFILE_FOLDER, get_current_dir_temp());
+    if (stage == PGO_GENERATE) {
+        cmd_append(cmd, temp_sprintf("-fprofile-generate=%s", profile));
+        if (config.compiler == GCC) cmd_append(cmd, "-fprofile-update=prefer-atomic");
+        return;
+    }
+
+    cmd_append(cmd, "-flto");
+    if (config.compiler == CLANG) {
+        cmd_append(cmd, temp_sprintf("-fprofile-use=%s/"PGO_PROFDATA, get_current_dir_temp()));
+        cmd_append(cmd, "-Wno-profile-instr-unprofiled", "-Wno-profile-instr-out-of-date");
+    } else {
+        cmd_append(cmd, temp_sprintf("-fprofile-use=%s", profile));
+        // most of SDL never runs during training, that code should still be optimized as usual
+        cmd_append(cmd, "-fprofile-partial-training", "-Wno-missing-profile");
+    }
+}
+
+bool build_sdl_pgo(Pgo_Stage stage) {
+    Nob_Cmd options = {0};
+    Nob_Cmd flags = {0};
+    Nob_String_Builder sb = {0};
+
+    cmd_append(&flags, "-O3", "-march=native");
+    append_pgo_flags(&flags, stage);
+    cmd_render(flags, &sb);
+    sb_append_null(&sb);
+
+    // Both stages share the cmake tree. gcc names the profile of each object after its path,
+    // so the objects of the optimized build have to be where the instrumented ones were
+    cmd_append(&options,
+        "-DBUILD_SHARED_LIBS=OFF",
+        "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
+        "-DCMAKE_BUILD_TYPE=Release",
+        config.compiler == CLANG ? "-DCMAKE_C_COMPILER=clang" : "-DCMAKE_C_COMPILER=gcc",
+        temp_sprintf("-DCMAKE_C_FLAGS=%s", sb.items));
+    // lets cmake pick the archiver that understands lto objects
+    if (stage == PGO_USE) cmd_append(&options, "-DCMAKE_INTERPROCEDURAL_OPTIMIZATION=ON");
+#ifdef __APPLE__
+    cmd_append(&options, "-DCMAKE_OSX_DEPLOYMENT_TARGET="MACOS_TARGET);
+#endif
+
+    bool result = build_sdl_cmake(SDL_BUILD_FOLDER"/native-pgo", &options, "libSDL3.a", PGO_SDL_FILE, false);
+    cmd_free(options);
+    cmd_free(flags);
+    sb_free(sb);
+    return result;
+}
+
+bool build_app_pgo_stage(Pgo_Stage stage, const char *output) {
+    bool result = true;
+    Nob_File_Paths sources = {0};
+    Nob_File_Paths objects = {0};
+    Nob_Procs procs = {0};
+
+    recursively_collect_files(SRC, &sources, allow_c_source_files);
+    qsort(sources.items, sources.count, sizeof(*sources.items), compare_paths);
+
+    // the objects keep the same paths in both stages for the same reason as SDL's
+    da_foreach(const char*, source, &sources) {
+        const char *object = object_path_in(PGO_OBJ_FOLDER, *source);
+        if (!mkdir_for_file(object)) return_defer(false);
+        da_append(&objects, object);
+
+        app_compile_flags();
+        append_pgo_flags(&cmd, stage);
+        cmd_append(&cmd, "-c", *source, "-o", object);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, get_jobs_count())) return_defer(false);
+    }
+    if (!procs_wait_and_reset(&procs)) return_defer(false);
+
+    app_compiler();
+    app_default_cmd();
+    append_pgo_flags(&cmd, stage);
+    da_append_many(&cmd, objects.items, objects.count);
+    append_renderer_libraries(PGO_SDL_FILE);
+    append_frameworks();
+    cmd_append(&cmd, "-o", output);
+    if (!cmd_run(&cmd)) return_defer(false);
+
+defer:
+    cmd.count = 0;
+    da_free(procs);
+    da_free(objects);
+    free_collected_files(&sources);
+    return result;
+}
+
+bool build_app_pgo(void) {
+    const char *instrumented = PGO_FOLDER"/main-instrumented.app";
+    Nob_File_Paths profiles = {0};
+
+    nob_log(NOB_INFO, "PGO 1/4: instrumented build");
+    if (!mkdir_for_file(PGO_PROFILE_FOLDER"/")) return false;
+    // profiles of older builds don't match the new objects
+    recursively_collect_files(PGO_PROFILE_FOLDER, &profiles, allow_all_files);
+    bool deleted = true;
+    da_foreach(const char*, profile, &profiles) {
+        if (!delete_file(*profile)) deleted = false;
+    }
+    free_collected_files(&profiles);
+    if (!deleted) return false;
+    if (!build_sdl_pgo(PGO_GENERATE)) return false;
+    if (!build_app_pgo_stage(PGO_GENERATE, instrumented)) return false;
+
+    nob_log(NOB_INFO, "PGO 2/4: training run of "PGO_TRAINING_FRAMES" frames");
+    setenv("SDL_VIDEO_DRIVER", "offscreen", 1);
+    setenv("SDL_AUDIO_DRIVER", "dummy", 1);
+    setenv("APP_TRAINING_FRAMES", PGO_TRAINING_FRAMES, 1);
+    cmd_append(&cmd, instrumented);
+    bool trained = cmd_run(&cmd);
+    unsetenv("SDL_VIDEO_DRIVER");
+    unsetenv("SDL_AUDIO_DRIVER");
+    unsetenv("APP_TRAINING_FRAMES");
+    if (!trained) return false;
+
+    nob_log(NOB_INFO, "PGO 3/4: merging profiles");
+    recursively_collect_files(PGO_PROFILE_FOLDER, &profiles, allow_all_files);
+    if (profiles.count == 0) {
+        nob_log(NOB_ERROR, "The training run did not write any profiles to "PGO_PROFILE_FOLDER);
+        free_collected_files(&profiles);
+        return false;
+    }
+    if (config.compiler == CLANG) {
+        cmd_append(&cmd, "llvm-profdata", "merge", "-output="PGO_PROFDATA);
+        da_append_many(&cmd, profiles.items, profiles.count);
+        if (!cmd_run(&cmd)) { free_collected_files(&profiles); return false; }
+    } else {
+        // gcc already accumulates the counters of every run into the .gcda files
+        nob_log(NOB_INFO, "%zu profiles recorded.", profiles.count);
+    }
+    free_collected_files(&profiles);
+
+    nob_log(NOB_INFO, "PGO 4/4: optimized build");
+    if (!build_sdl_pgo(PGO_USE)) return false;
+    if (!build_app_pgo_stage(PGO_USE, EXE_NAME)) return false;
+    return true;
+}
+#endif // _WIN32
+
+// Building SDL without cmake
+
+// Compiles the Linux subset of SDL straight from its sources using lib/sdl-direct/SDL_build_config.h
+// instead of the header cmake would generate. There is no configure step at all.
+#define SDL_DIRECT_FOLDER SDL_BUILD_FOLDER"/direct"
+#define SDL_DIRECT_CONFIG "lib/sdl-direct"
+#define SDL_WAYLAND_PROTOCOLS SDL_DIRECT_FOLDER"/wayland-generated-protocols"
+#define SDL_DIRECT_FLAGS SDL_DIRECT_FOLDER"/flags.txt"
+#define SDL_DIRECT_ARCHIVED SDL_DIRECT_FOLDER"/archived.txt"
+#define SDL_DIRECT_UNITY SDL_DIRECT_FOLDER"/obj/unity"
+
+// every .c file directly inside of these folders is compiled. Backends that are not enabled
+// by SDL_build_config.h compile to empty objects
+const char *sdl_direct_folders[] = {
+    "src", "src/atomic", "src/core", "src/core/linux", "src/core/unix", "src/cpuinfo",
+    "src/dynapi", "src/events", "src/io", "src/io/generic", "src/libm", "src/locale",
+    "src/locale/unix", "src/main", "src/main/generic", "src/misc", "src/misc/unix",
+    "src/power", "src/power/linux", "src/process", "src/process/posix", "src/stdlib",
+    "src/loadso/dlopen", "src/thread", "src/thread/pthread", "src/time", "src/time/unix",
+    "src/timer", "src/timer/unix", "src/filesystem", "src/filesystem/posix",
+    "src/filesystem/unix", "src/storage", "src/storage/generic", "src/storage/steam",
+    "src/dialog", "src/dialog/unix", "src/tray", "src/tray/unix",
+    // audio
+    "src/audio", "src/audio/disk", "src/audio/dummy", "src/audio/pulseaudio",
+    "src/audio/pipewire", "src/audio/alsa",
+    // input
+    "src/haptic", "src/haptic/linux", "src/hidapi", "src/joystick", "src/joystick/hidapi",
+    "src/joystick/linux", "src/joystick/virtual", "src/sensor", "src/sensor/dummy",
+    "src/camera", "src/camera/dummy", "src/camera/v4l2",
+    // video
+    "src/video", "src/video/dummy", "src/video/offscreen", "src/video/x11",
+    "src/video/wayland", "src/video/yuv2rgb", "src/render", "src/render/software",
+    "src/render/opengl", "src/render/opengles2", "src/render/vulkan", "src/render/gpu",
+    "src/gpu", "src/gpu/vulkan",
+};
+
+// these are not guarded by the config and cmake only adds them when their dependency was found
+const char *sdl_direct_skipped[] = {
+    "src/core/linux/SDL_fcitx.c", // needs dbus
+    "src/core/linux/SDL_system_theme.c", // needs dbus
+};
+
+bool sdl_direct_is_skipped(const char *path) {
+    String_View sv = sv_from_cstr(path);
+    for (size_t i = 0; i < ARRAY_LEN(sdl_direct_skipped); ++i) {
+        if (sv_end_with(sv, sdl_direct_skipped[i])) return true;
+    }
+    return false;
+}
+
+bool program_exists(const char *name) {
+    const char *path = getenv("PATH");
+    if (path == NULL) return false;
+    String_View paths = sv_from_cstr(path);
+    while (paths.count > 0) {
+        String_View dir = sv_chop_by_delim(&paths, ':');
+        if (dir.count == 0) continue;
+        if (file_exists(temp_sprintf(SV_Fmt"/%s", SV_Arg(dir), name)) == 1) return true;
+    }
+    return false;
+}
+
+// runs wayland-scanner over SDL's protocol files and appends the generated sources
+bool generate_wayland_protocols(Nob_File_Paths *sources) {
+    if (!program_exists("wayland-scanner")) {
+        nob_log(NOB_INFO, "wayland-scanner not found, building SDL without Wayland.");
+        return true;
+    }
+    if (!mkdir_for_file(SDL_WAYLAND_PROTOCOLS"/")) return false;
+
+    Nob_File_Paths protocols = {0};
+    if (!read_entire_dir(SDL_PATH"/wayland-protocols", &protocols)) return false;
+
+    da_foreach(const char*, name, &protocols) {
+        String_View protocol = sv_from_cstr(*name);
+        if (!sv_end_with(protocol, ".xml")) continue;
+        protocol.count -= 4;
+
+        const char *xml = temp_sprintf(SDL_PATH"/wayland-protocols/%s", *name);
+        const char *header = temp_sprintf(SDL_WAYLAND_PROTOCOLS"/"SV_Fmt"-client-protocol.h", SV_Arg(protocol));
+        const char *code = temp_sprintf(SDL_WAYLAND_PROTOCOLS"/"SV_Fmt"-protocol.c", SV_Arg(protocol));
+
+        if (needs_rebuild1(header, xml)) {
+            cmd_append(&cmd, "wayland-scanner", "client-header", xml, header);
+            if (!cmd_run(&cmd)) return false;
+        }
+        if (needs_rebuild1(code, xml)) {
+            cmd_append(&cmd, "wayland-scanner", "private-code", xml, code);
+            if (!cmd_run(&cmd)) return false;
+        }
+        da_append(sources, code);
+    }
+
+    da_free(protocols);
+    return true;
+}
+
+// The include flags of pipewire from pkg-config, as -isystem like the other system headers. Without
+// them SDL_build_config.h does not find the headers and leaves the pipewire driver out.
+const Nob_Cmd *sdl_direct_pipewire_flags(void) {
+    static Nob_Cmd flags = {0};
+    static bool queried = false;
+    if (queried) return &flags;
+    queried = true;
+
+    // called while the global cmd holds the compile command
+    Nob_Cmd query = {0};
+    Nob_String_Builder out = {0};
+    Nob_String_Builder err = {0};
+    bool found = false;
+    if (program_exists("pkg-config")) {
+        // not having pipewire is fine, pkg-config failing is how we find out
+        Nob_Log_Level level = minimal_log_level;
+        minimal_log_level = NOB_NO_LOGS;
+        cmd_append(&query, "pkg-config", "--cflags", "libpipewire-0.3");
+        found = cmd_run_capture(&query, &out, &err);
+        minimal_log_level = level;
+    }
+    if (!found) nob_log(NOB_INFO, "pipewire not found by pkg-config, building SDL without it.");
+
+    String_View rest = sb_to_sv(out);
+    while (found && rest.count > 0) {
+        String_View flag = sv_trim(sv_chop_by_delim(&rest, ' '));
+        if (flag.count == 0) continue;
+        if (sv_starts_with(flag, sv_from_cstr("-I"))) {
+            sv_chop_left(&flag, 2);
+            cmd_append(&flags, "-isystem");
+        }
+        const char *copy = strdup(temp_sv_to_cstr(flag));
+        NOB_ASSERT(copy != NULL && "Buy more RAM lool!!");
+        cmd_append(&flags, copy);
+    }
+    cmd_free(query);
+    sb_free(out);
+    sb_free(err);
+    return &flags;
+}
+
+void sdl_direct_compile_cmd(void) {
+    app_compiler();
+    cmd_append(&cmd, "-O2", "-g", "-fPIC", "-fno-strict-aliasing", "-D_REENTRANT");
+    cmd_append(&cmd,
+        "-DSDL_BUILD_MAJOR_VERSION=3",
+        "-DSDL_BUILD_MINOR_VERSION=2",
+        "-DSDL_BUILD_MICRO_VERSION=16",
+        "-DSDL_STATIC_LIB",
+        "-DUSING_GENERATED_CONFIG_H");
+    cmd_append(&cmd, "-I"SDL_DIRECT_CONFIG, "-I"SDL_PATH"/include", "-I"SDL_PATH"/src");
+    cmd_append(&cmd, "-idirafter", SDL_PATH"/src/video/khronos");
+    cmd_append(&cmd, "-isystem", SDL_WAYLAND_PROTOCOLS);
+    const Nob_Cmd *pipewire = sdl_direct_pipewire_flags();
+    da_append_many(&cmd, pipewire->items, pipewire->count);
+}
+
+// Remembers how long building every SDL file took in this mode and compares it with the other one.
+bool report_full_build_time(bool unity, unsigned long long usec) {
+    const char *this_path = temp_sprintf(SDL_DIRECT_FOLDER"/full_build_%s.txt", unity ? "unity" : "per_file");
+    const char *other_path = temp_sprintf(SDL_DIRECT_FOLDER"/full_build_%s.txt", unity ? "per_file" : "unity");
+    const char *content = temp_sprintf("%llu", usec);
+    if (!write_entire_file(this_path, content, strlen(content))) return false;
+
+    if (file_exists(other_path)) {
+        Nob_String_Builder sb = {0};
+        if (!read_entire_file(other_path, &sb)) return false;
+        sb_append_null(&sb);
+        float other = (float)strtoull(sb.items, NULL, 10) / 1000000.0f;
+        float this = (float)usec / 1000000.0f;
+        float unity_time = unity ? this : other;
+        float per_file_time = unity ? other : this;
+        nob_log(NOB_INFO, "Full SDL build: unity %0.3fs, per-file %0.3fs (%+0.3fs).",
+                unity_time, per_file_time, unity_time - per_file_time);
+        sb_free(sb);
+    }
+    return true;
+}
+
+bool build_sdl_direct(bool force_rebuild, bool unity) {
+    bool result = true;
+    unsigned long long start = get_timestamp_usec();
+
+    Nob_File_Paths sources = {0};
+    Nob_File_Paths objects = {0};
+    Nob_String_Builder flags = {0};
+    Nob_String_Builder archived = {0};
+    Nob_File_Paths compiled = {0};
+    Nob_Procs procs = {0};
+    size_t max_jobs = get_jobs_count();
+    bool retry = false;
+
+    for (size_t i = 0; i < ARRAY_LEN(sdl_direct_folders); ++i) {
+        const char *folder = temp_sprintf(SDL_PATH"/%s", sdl_direct_folders[i]);
+        Nob_File_Paths entries = {0};
+        if (!read_entire_dir(folder, &entries)) return_defer(false);
+        qsort(entries.items, entries.count, sizeof(*entries.items), compare_paths);
+        da_foreach(const char*, entry, &entries) {
+            const char *path = temp_sprintf("%s/%s", folder, *entry);
+            if (allow_c_source_files(path) && !sdl_direct_is_skipped(path)) da_append(&sources, path);
+        }
+        da_free(entries);
+    }
+    if (!generate_wayland_protocols(&sources)) return_defer(false);
+    if (unity && !unity_batch_sources(&sources, SDL_DIRECT_UNITY)) return_defer(false);
+
+    // the objects only depend on nob.c through the flags, so don't recompile SDL on every edit of it
+    sdl_direct_compile_cmd();
+    cmd_render(cmd, &flags);
+    cmd.count = 0;
+    if (!force_rebuild) {
+        int differs = file_content_differs(SDL_DIRECT_FLAGS, sb_to_sv(flags));
+        if (differs < 0) return_defer(false);
+        force_rebuild = differs;
+    }
+
+    da_foreach(const char*, source, &sources) {
+        char *object = object_path_in(SDL_DIRECT_FOLDER"/obj", *source);
+        char *depfile = depfile_path_for_object(object);
+        da_append(&objects, object);
+
+        if (!force_rebuild) {
+            int rebuild = needs_rebuild_depfile(object, depfile);
+            if (rebuild < 0) return_defer(false);
+            if (rebuild == 0) continue;
+        }
+
+        // the compile failed when it left no object behind
+        if (!mkdir_for_file(object) || !delete_if_exists(object)) return_defer(false);
+        sdl_direct_compile_cmd();
+        nob_cc_depfile(&cmd, depfile);
+        cmd_append(&cmd, "-c", *source, "-o", object);
+
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (proc == INVALID_PROC) return_defer(false);
+        da_append(&compiled, *source);
+        // the failures are found through the objects below
+        procs_append_with_flush(&procs, proc, max_jobs);
+    }
+    procs_wait_and_reset(&procs);
+
+    // a unity batch that does not compile has a collision the scan did not see, so its files
+    // are split out and the build is retried. Any other failure is a real error
+    da_foreach(const char*, source, &compiled) {
+        if (file_exists(object_path_in(SDL_DIRECT_FOLDER"/obj", *source)) == 1) continue;
+        if (unity && sv_starts_with(sv_from_cstr(*source), sv_from_cstr(SDL_DIRECT_UNITY"/"))) {
+            nob_log(NOB_WARNING, "Unity batch %s failed, its files will be compiled separately.", *source);
+            if (!unity_exclude_batch(*source, SDL_DIRECT_UNITY)) return_defer(false);
+            retry = true;
+        } else {
+            result = false;
+        }
+    }
+    if (!result) return_defer(false);
+    if (retry) return_defer(build_sdl_direct(false, unity));
+    if (!write_entire_file(SDL_DIRECT_FLAGS, flags.items, flags.count)) return_defer(false);
+
+    // switching between unity and per-file builds changes the members without touching anything newer
+    da_foreach(const char*, object, &objects) {
+        sb_append_cstr(&archived, *object);
+        sb_append_cstr(&archived, "\n");
+    }
+    int rearchive = file_content_differs(SDL_DIRECT_ARCHIVED, sb_to_sv(archived));
+    if (rearchive == 0) rearchive = needs_rebuild(SDL_FILE, objects.items, objects.count);
+    if (rearchive < 0) return_defer(false);
+    if (compiled.count > 0 || rearchive) {
+        // ar only ever adds members, so objects of removed sources would stay in the old archive
+        if (file_exists(SDL_FILE) && !delete_file(SDL_FILE)) return_defer(false);
+        cmd_append(&cmd, "ar", "rcs", SDL_FILE);
+        da_append_many(&cmd, objects.items, objects.count);
+        if (!cmd_run(&cmd)) return_defer(false);
+        if (!write_entire_file(SDL_DIRECT_ARCHIVED, archived.items, archived.count)) return_defer(false);
+    }
+
+    unsigned long long took = get_timestamp_usec() - start;
+    nob_log(NOB_INFO, "SDL: compiled %zu of %zu files in %0.3fs.", compiled.count, sources.count, (float)took / 1000000.0f);
+    if (compiled.count == sources.count && !report_full_build_time(unity, took)) return_defer(false);
+
+defer:
+    // don't leave the children running when bailing out
+    procs_wait(procs);
+    cmd.count = 0;
+    da_free(procs);
+    da_free(compiled);
+    da_free(objects);
+    da_free(sources);
+    sb_free(flags);
+    sb_free(archived);
+    return result;
+}
+
+// Benchmarks
+
+#define BENCH_SPAWN_COUNT 1000
+// fork() copies the page tables of the parent, so it gets slower the more memory nob has touched
+#define BENCH_SPAWN_HEAP (256*1024*1024)
+
+#ifndef _WIN32
+// how nob_cmd_start_process() used to launch processes before it used posix_spawn()
+Nob_Proc bench_fork_exec(Nob_Cmd command) {
+    pid_t pid = fork();
+    if (pid < 0) return INVALID_PROC;
+    if (pid == 0) {
+        Nob_Cmd cmd_null = {0};
+        da_append_many(&cmd_null, command.items, command.count);
+        cmd_append(&cmd_null, NULL);
+        execvp(command.items[0], (char * const*) cmd_null.items);
+        _exit(127);
+    }
+    return pid;
+}
+#endif
+
+bool bench_spawn_run(const char *name, Nob_Proc (*start)(Nob_Cmd), size_t count) {
+    unsigned long long start_usec = get_timestamp_usec();
+    for (size_t i = 0; i < count; ++i) {
+        cmd_append(&cmd, "true");
+        Nob_Proc proc = start(cmd);
+        cmd.count = 0;
+        if (!proc_wait(proc)) return false;
+    }
+    float took = (float)(get_timestamp_usec() - start_usec) / 1000000.0f;
+    nob_log(NOB_WARNING, "  %-24s %zu processes in %0.3fs, %0.0f/s", name, count, took, (float)count / took);
+    return true;
+}
+
+Nob_Proc bench_cmd_start_process(Nob_Cmd command) {
+    return cmd_start_process(command, NULL, NULL, NULL);
+}
+
+// Launches `true` over and over, with a small nob and with one that touched a lot of memory like
+// a nob in the middle of a big build. The results are logged as warnings, the rest is silenced
+// the way a quiet build would be.
+bool bench_spawn(int argc, char **argv) {
+    size_t count = argc > 0 ? strtoul(argv[0], NULL, 10) : BENCH_SPAWN_COUNT;
+    if (count == 0) count = BENCH_SPAWN_COUNT;
+    bool result = true;
+    Nob_Log_Level level = minimal_log_level;
+    minimal_log_level = NOB_WARNING;
+    nob_trace.enabled = false;
+    char *heap = NULL;
+
+    for (int touched = 0; touched < 2; ++touched) {
+        if (touched) {
+            heap = malloc(BENCH_SPAWN_HEAP);
+            assert(heap != NULL);
+            memset(heap, 1, BENCH_SPAWN_HEAP);
+        }
+        nob_log(NOB_WARNING, "Spawning with %s:", touched ? "256 MiB touched" : "a small nob");
+#ifndef _WIN32
+        if (!bench_spawn_run("fork+execvp", bench_fork_exec, count)) return_defer(false);
+#endif
+        if (!bench_spawn_run("nob_cmd_start_process", bench_cmd_start_process, count)) return_defer(false);
+    }
+
+defer:
+    free(heap);
+    minimal_log_level = level;
+    return result;
+}
+
+#define BENCH_WALK_ROUNDS 5
+
+// how recursively_collect_files() used to walk: one directory after the other, a stat for every
+// entry, and nob_needs_rebuild() stat'ed every file once more
+void bench_walk_serial(const char *parent, Nob_File_Paths *out) {
+    Nob_File_Paths entries = {0};
+    if (!read_entire_dir(parent, &entries)) return;
+    for (size_t i = 0; i < entries.count; ++i) {
+        const char *sub = entries.items[i];
+        if (strcmp(sub, ".") == 0 || strcmp(sub, "..") == 0) continue;
+        char *path = temp_sprintf("%s/%s", parent, sub);
+        Nob_File_Type t = get_file_type(path);
+        if (t == NOB_FILE_DIRECTORY) {
+            bench_walk_serial(path, out);
+        } else if (t == NOB_FILE_REGULAR) {
+            da_append(out, temp_strdup(path));
+        }
+    }
+    da_free(entries);
+}
+
+// Collects all of lib/SDL-3.2.16/src and checks it against an output, the way sdl_sources_changed()
+// does. The best of a few rounds is logged, so the page cache is warm for every variant.
+bool bench_walk(int argc, char **argv) {
+    const char *root = argc > 0 ? argv[0] : SDL_PATH"/src";
+    Nob_Log_Level level = minimal_log_level;
+    minimal_log_level = NOB_WARNING;
+    nob_trace.enabled = false;
+    Nob_File_Paths files = {0};
+    size_t threads_variants[] = {0, 1, 2, 4, 8};
+
+    for (size_t v = 0; v < ARRAY_LEN(threads_variants); ++v) {
+        size_t threads = threads_variants[v];
+        float best = 0;
+        for (size_t round = 0; round < BENCH_WALK_ROUNDS; ++round) {
+            stat_cache_reset();
+            size_t mark = temp_save();
+            unsigned long long start = get_timestamp_usec();
+            files.count = 0;
+            if (threads == 0) {
+                bench_walk_serial(root, &files);
+                for (size_t i = 0; i < files.count; ++i) {
+                    struct stat statbuf;
+                    if (stat(files.items[i], &statbuf) < 0) return false;
+                }
+            } else {
+                if (!walk_files(root, &files, NULL, threads)) return false;
+                if (needs_rebuild(SDL_FILE, files.items, files.count) < 0) return false;
+            }
+            float took = (float)(get_timestamp_usec() - start) / 1000000.0f;
+            if (round == 0 || took < best) best = took;
+            if (threads > 0) {
+                for (size_t i = 0; i < files.count; ++i) free((char*)files.items[i]);
+            }
+            temp_rewind(mark);
+        }
+        if (threads == 0) {
+            nob_log(NOB_WARNING, "  %-24s %zu files in %0.4fs", "serial walk + stat", files.count, best);
+        } else {
+            nob_log(NOB_WARNING, "  %-24s %zu files in %0.4fs", temp_sprintf("walk_files, %zu threads", threads), files.count, best);
+        }
+    }
+
+    da_free(files);
+    minimal_log_level = level;
+    return true;
+}
+
+#define BENCH_MAP_LINEAR_LOOKUPS 1000
+
+typedef struct {
+    String_View key;
+    size_t index;
+} Bench_Path;
+
+typedef struct {
+    Bench_Path *items;
+    size_t count;
+    size_t capacity;
+} Bench_Paths;
+
+typedef struct {
+    String_View *items;
+    size_t count;
+    size_t capacity;
+} Bench_Keys;
+
+// Looks up paths of a made up source tree in a hash map and with a linear scan of an array, the
+// way a build graph would find the node of a path. The linear scan only gets a sample of the
+// lookups, it takes too long otherwise.
+bool bench_map(int argc, char **argv) {
+    (void)argc; (void)argv;
+    size_t sizes[] = {10000, 100000};
+    for (size_t s = 0; s < ARRAY_LEN(sizes); ++s) {
+        size_t n = sizes[s];
+        Interner interner = {0};
+        Bench_Keys paths = {0};
+        Bench_Paths map = {0};
+
+        for (size_t i = 0; i < n; ++i) {
+            String_View path = sv_from_cstr(temp_sprintf("lib/module%zu/src/dir%zu/file%zu.c", i % 97, i % 31, i));
+            da_append(&paths, intern(&interner, path));
+        }
+        temp_reset();
+
+        unsigned long long start = get_timestamp_usec();
+        for (size_t i = 0; i < n; ++i) {
+            Bench_Path *path = ht_put(&map, paths.items[i]);
+            path->index = i;
+        }
+        float insert = (float)(get_timestamp_usec() - start) / 1000.0f;
+
+        // look up copies, so the interned pointers don't give the answer away
+        Nob_String_Builder copy = {0};
+        size_t found = 0;
+        start = get_timestamp_usec();
+        for (size_t i = 0; i < n; ++i) {
+            String_View key = paths.items[(i*7919) % n];
+            copy.count = 0;
+            sb_append_buf(&copy, key.data, key.count);
+            Bench_Path *path = ht_get(&map, sb_to_sv(copy));
+            if (path != NULL) found += 1;
+        }
+        float hashed = (float)(get_timestamp_usec() - start) * 1000.0f / (float)n;
+
+        start = get_timestamp_usec();
+        for (size_t i = 0; i < BENCH_MAP_LINEAR_LOOKUPS; ++i) {
+            String_View key = paths.items[(i*7919) % n];
+            copy.count = 0;
+            sb_append_buf(&copy, key.data, key.count);
+            for (size_t j = 0; j < paths.count; ++j) {
+                if (sv_eq(paths.items[j], sb_to_sv(copy))) {
+                    found += 1;
+                    break;
+                }
+            }
+        }
+        float linear = (float)(get_timestamp_usec() - start) * 1000.0f / BENCH_MAP_LINEAR_LOOKUPS;
+
+        if (found != n + BENCH_MAP_LINEAR_LOOKUPS) {
+            nob_log(NOB_ERROR, "Lost %zu paths", n + BENCH_MAP_LINEAR_LOOKUPS - found);
+            return false;
+        }
+        nob_log(NOB_INFO, "%zu paths: inserted in %0.2fms, %0.0fns per lookup in the map, %0.0fns with a linear scan",
+                n, insert, hashed, linear);
+
+        sb_free(copy);
+        ht_free(map);
+        da_free(paths);
+        interner_free(&interner);
+    }
+    return true;
+}
+
+// Main
 
 bool build_clean_all(int argc, char **argv) {
     (void)argc; (void)argv;
@@ -784,6 +2369,7 @@ bool build_app_config(Config config) {
     unsigned long long start = get_timestamp_usec();
 
     bool config_did_change = false;
+    bool sdl_did_change = false;
     if (!config.force_rebuild) {
         nob_log(NOB_INFO, "Previously built:");
         log_config_string(config);
@@ -791,60 +2377,59 @@ bool build_app_config(Config config) {
 
         if (!load_config_from_file(CONFIG_FILE_PATH, &saved_config)) {
             config_did_change = true;
-        } else if (config.optimize == saved_config.optimize && config.compiler == saved_config.compiler) {
+        } else if (config.optimize == saved_config.optimize && config.compiler == saved_config.compiler && config.unity == saved_config.unity
+                   && config.pch == saved_config.pch && config.pgo == saved_config.pgo) {
             config_did_change = false;
         } else {
             config_did_change = true;
         }
+        sdl_did_change = config.sdl_direct != saved_config.sdl_direct;
     }
 
     minimal_log_level = NOB_NO_LOGS;
     mkdir_if_not_exists(BUILD_FOLDER);
     minimal_log_level = 0;
 
-    Nob_File_Paths app_inputs = {0};
-    da_append(&app_inputs, "nob.c");
-    recursively_collect_files(SRC, &app_inputs, allow_c_files);
-
-    printf("\n");
-    unsigned long long end = get_timestamp_usec();
-    nob_log(NOB_INFO, "Took %0.4fs.", (float)(end - start) / 1000000.0f);
-
     // Run the app
     switch (config.platform) {
         case PLATFORM_NATIVE: {
-            bool files_changed = needs_rebuild(EXE_NAME, app_inputs.items, app_inputs.count) == 1;
             if (config_did_change) {
                 nob_log(NOB_INFO, "Config changed after last build.");
                 log_config_string(config);
-            } else if (files_changed) {
-                nob_log(NOB_INFO, "Sources were changed.");
             } else if (config.force_rebuild) {
                 nob_log(NOB_INFO, "Forced rebuild.");
-            } else {
-                nob_log(NOB_INFO, "Executable is up to date.");
             }
 
-            if (!build_sdl(false)) return false;
+#ifndef _WIN32
+            if (config.pgo) {
+                // every stage depends on the one before, so the pipeline always runs in full
+                if (!build_app_pgo()) return false;
+                break;
+            }
+#endif
 
-            if (config_did_change || files_changed || config.force_rebuild) {
-                if (!build_app_native()) return false;
+            // both ways of building SDL produce the same archive, make sure the other one's is not reused
+            if (sdl_did_change && file_exists(SDL_FILE) && !delete_file(SDL_FILE)) return false;
+            if (config.sdl_direct) {
+                if (!build_sdl_direct(false, config.unity)) return false;
+            } else {
+                // SDL's cmake project does not support CMAKE_UNITY_BUILD, so only the app is batched
+                if (!build_sdl(false)) return false;
             }
+            if (!build_app_native(config_did_change || sdl_did_change || config.force_rebuild, config.unity)) return false;
         } break;
         case ANDROID: {
-            cmd_append(&cmd, "rm", "-r", ANDROID_BUILD);
-            cmd_run(&cmd);
-
+            // the build folder is kept between builds, the stages only run when their inputs changed
             mkdir_if_not_exists(ANDROID_BUILD);
             mkdir_if_not_exists(ANDROID_BUILD"/java");
             mkdir_if_not_exists(ANDROID_APK_FOLDER);
             mkdir_if_not_exists(ANDROID_APK_FOLDER"/lib");
-            mkdir_if_not_exists(ANDROID_APK_FOLDER"/lib/"ANDROID_ABI);
             mkdir_if_not_exists(ANDROID_APK_FOLDER"/assets");
 
+            if (!parse_android_abis()) return false;
             if (!create_android_keystore()) return false;
             if (!build_sdl_android()) return false;
-            if (!build_app_android()) return false;
+            if (!build_app_android(config_did_change || config.force_rebuild)) return false;
         } break;
         case IOS: {
             cmd_append(&cmd, "rm", "-r", IOS_BUILD);
@@ -854,57 +2439,957 @@ bool build_app_config(Config config) {
             if (!mkdir_if_not_exists(BUILD_FOLDER "/ios/bin")) return false;
             if (!mkdir_if_not_exists(IOS_APP_BUNDLE)) return false;
 
-            if (!build_sdl_ios(&config)) return false;
-            if (!build_app_ios()) return false;
+            Nob_Capture sdk_path = {0};
+            if (!start_ios_sdk_path_query(&sdk_path)) return false;
+            bool built = build_sdl_ios(&config);
+            if (!captures_wait(&sdk_path, 1) || !built) {
+                capture_free(&sdk_path);
+                return false;
+            }
+            bool result = build_app_ios(temp_sv_to_cstr(sv_trim(sb_to_sv(sdk_path.out))));
+            capture_free(&sdk_path);
+            if (!result) return false;
         } break;
     }
 
     dump_config_to_file(CONFIG_FILE_PATH, config);
 
+    printf("\n");
+    unsigned long long end = get_timestamp_usec();
+    nob_log(NOB_INFO, "Took %0.4fs.", (float)(end - start) / 1000000.0f);
+
+    if (cache_stats.hits + cache_stats.misses > 0) {
+        nob_log(NOB_INFO, "Build cache: %zu hits, %zu misses.", cache_stats.hits, cache_stats.misses);
+    }
+    // only a build that stored something can have grown the cache
+    if (cache_stats.misses > 0 && !cache_trim()) return false;
+    if (copy_stats.copied + copy_stats.skipped > 0) {
+        nob_log(NOB_INFO, "Copied %zu files (%.1f MiB), %zu were up to date.",
+                copy_stats.copied, (double)copy_stats.bytes / (1024.0*1024.0), copy_stats.skipped);
+    }
+    Temp_Stats temp = temp_stats();
+    nob_log(NOB_INFO, "Temporary storage peaked at %zu KiB, %zu blocks are mapped.", temp.high_water / 1024, temp.blocks);
+
     return true;
 }
 
-bool build_app_all_configs(void) {
-    if (!build_app_config((Config) {
-        .platform = PLATFORM_NATIVE,
-        .force_rebuild = true,
-    })) return 1;
+// The test matrix. Every config is built by a nob of its own in BUILD_FOLDER"/matrix/<name>", a
+// workspace that links to the sources, so each one has its own build folder and .config and all of
+// them run at the same time. The children join our jobserver, so they share one job budget.
 
-    if (!build_app_config((Config) {
-        .platform = ANDROID,
-    })) return 1;
+#define MATRIX_FOLDER BUILD_FOLDER"/matrix"
+
+typedef struct {
+    const char *name;
+    const char *args[3];
+} Matrix_Config;
 
+static const Matrix_Config matrix_configs[] = {
+    { "native",     { "-f" } },
+    { "android",    { "-android" } },
 #ifdef __APPLE__
-    if (!build_app_config((Config) {
-        .platform = IOS,
-    })) return 1;
-
-    if (!build_app_config((Config) {
-        .platform = IOS,
-        .device = true
-    })) return 1;
+    { "ios",        { "-ios" } },
+    { "ios-device", { "-ios", "-device" } },
 #endif
+};
+
+// what the build reads from the root of the repository
+static const char *matrix_workspace_links[] = { "src", "include", "lib", "android", "ios", "env", "nob.c" };
+
+bool link_into_workspace(const char *workspace, const char *name) {
+    const char *link = temp_sprintf("%s/%s", workspace, name);
+#ifdef _WIN32
+    DWORD flags = SYMBOLIC_LINK_FLAG_ALLOW_UNPRIVILEGED_CREATE;
+    if (get_file_type(name) == FILE_DIRECTORY) flags |= SYMBOLIC_LINK_FLAG_DIRECTORY;
+    if (GetFileAttributesA(link) != INVALID_FILE_ATTRIBUTES) return true;
+    if (!CreateSymbolicLinkA(link, temp_sprintf("..\\..\\..\\%s", name), flags)) {
+        nob_log(NOB_ERROR, "Could not link %s: %s", link, nob_win32_error_message(GetLastError()));
+        return false;
+    }
+#else
+    if (symlink(temp_sprintf("../../../%s", name), link) < 0 && errno != EEXIST) {
+        nob_log(NOB_ERROR, "Could not link %s: %s", link, strerror(errno));
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool build_app_all_configs(const char *nob_path) {
+    bool result = true;
+    size_t count = ARRAY_LEN(matrix_configs);
+    Nob_Procs procs = {0};
+    Nob_Proc started[ARRAY_LEN(matrix_configs)];
+    unsigned long long took[ARRAY_LEN(matrix_configs)] = {0};
+    int status[ARRAY_LEN(matrix_configs)] = {0}; // 0 running, 1 ok, -1 failed
+    unsigned long long start = get_timestamp_usec();
+
+    if (!mkdir_if_not_exists(MATRIX_FOLDER)) return false;
+    for (size_t i = 0; i < count; ++i) {
+        const Matrix_Config *it = &matrix_configs[i];
+        const char *workspace = temp_sprintf(MATRIX_FOLDER"/%s", it->name);
+        if (!mkdir_if_not_exists(workspace)) return_defer(false);
+        for (size_t j = 0; j < ARRAY_LEN(matrix_workspace_links); ++j) {
+            if (!file_exists(matrix_workspace_links[j])) continue;
+            if (!link_into_workspace(workspace, matrix_workspace_links[j])) return_defer(false);
+        }
+
+        // the logs of the configs would be interleaved, each one goes into its workspace
+        const char *log_path = temp_sprintf("%s/nob.log", workspace);
+        Nob_Fd log = fd_open_for_write(log_path);
+        if (log == INVALID_FD) return_defer(false);
+        cmd_append(&cmd, nob_path, "-C", workspace);
+        for (size_t j = 0; j < ARRAY_LEN(it->args) && it->args[j] != NULL; ++j) cmd_append(&cmd, it->args[j]);
+        started[i] = cmd_start_process(cmd, NULL, &log, &log);
+        cmd.count = 0;
+        fd_close(log);
+        if (started[i] == INVALID_PROC) return_defer(false);
+        nob_log(NOB_INFO, "Building %s, see %s", it->name, log_path);
+        da_append(&procs, started[i]);
+    }
+
+    while (procs.count > 0) {
+        Nob_Proc finished;
+        bool ok = procs_wait_any(&procs, &finished);
+        for (size_t i = 0; i < count; ++i) {
+            if (started[i] != finished) continue;
+            took[i] = get_timestamp_usec() - start;
+            status[i] = ok ? 1 : -1;
+            if (!ok) result = false;
+        }
+    }
+
+    nob_log(NOB_INFO, "%-12s %-8s %s", "Config", "Result", "Time");
+    for (size_t i = 0; i < count; ++i) {
+        nob_log(NOB_INFO, "%-12s %-8s %0.3fs", matrix_configs[i].name, status[i] > 0 ? "ok" : "FAILED", (float)took[i] / 1000000.0f);
+    }
+    nob_log(NOB_INFO, "The matrix took %0.3fs", (float)(get_timestamp_usec() - start) / 1000000.0f);
+
+defer:
+    if (!procs_wait_and_reset(&procs)) result = false;
+    da_free(procs);
+    return result;
+}
+
+#define TRACE_FILE_PATH BUILD_FOLDER"/trace.json"
+
+// every process of this run ends up in the trace, which can be opened in https://ui.perfetto.dev
+void finish_trace(void) {
+    if (nob_trace.count == 0) return;
+    int level = minimal_log_level;
+    minimal_log_level = NOB_NO_LOGS;
+    mkdir_if_not_exists(BUILD_FOLDER);
+    bool written = trace_write_json(TRACE_FILE_PATH);
+    minimal_log_level = level;
+    if (written) nob_log(NOB_INFO, "Trace of %zu processes written to "TRACE_FILE_PATH".", nob_trace.count);
+    trace_log_slowest(10);
+    trace_reset();
+}
+
+// clangd finds the database in build/ on its own
+#define COMPDB_FILE_PATH BUILD_FOLDER"/compile_commands.json"
+
+// The sources that were not compiled this time keep their commands from the SDL database of the
+// platform and from the previous database, so the platform that compiled a source last wins
+void finish_compdb(void) {
+    const char *merge[] = { compdb_sdl_database };
+    int merge_changed = needs_rebuild(COMPDB_FILE_PATH, merge, file_exists(merge[0]) == 1 ? 1 : 0);
+    if (nob_compdb.count == 0 && merge_changed == 0) return;
+    int level = minimal_log_level;
+    minimal_log_level = NOB_WARNING;
+    mkdir_if_not_exists(BUILD_FOLDER);
+    compdb_write(COMPDB_FILE_PATH, merge, ARRAY_LEN(merge));
+    minimal_log_level = level;
+    compdb_reset();
+}
+
+#define MANIFEST_FILE_PATH BUILD_FOLDER"/.manifest"
+
+// the content hashes that keep touched but unchanged files from causing rebuilds
+void finish_manifest(void) {
+    int level = minimal_log_level;
+    minimal_log_level = NOB_WARNING;
+    if (file_exists(BUILD_FOLDER) == 1) manifest_save();
+    minimal_log_level = level;
+}
+
+// Watch mode
+
+// `./nob watch` builds the app once and then stays resident. It listens for changes with inotify,
+// recompiles only the objects whose dependencies changed, relinks and restarts main.app. The
+// sources and what their depfiles list are kept in memory between the rebuilds.
+#ifdef __linux__
+
+// after the first event wait this long for more, editors tend to save a file in several steps
+#define WATCH_SETTLE_MS 50
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+
+typedef struct {
+    char *source;
+    char *object;
+    Nob_File_Paths deps;
+} Watch_Unit;
+
+typedef struct {
+    Watch_Unit *items;
+    size_t count;
+    size_t capacity;
+} Watch_Units;
+
+typedef struct {
+    int wd;
+    char *path;
+} Watch_Dir;
+
+typedef struct {
+    Watch_Dir *items;
+    size_t count;
+    size_t capacity;
+} Watch_Dirs;
+
+void watch_unit_free_deps(Watch_Unit *unit) {
+    da_foreach(const char*, dep, &unit->deps) free((char*)*dep);
+    unit->deps.count = 0;
+}
+
+void watch_units_free(Watch_Units *units) {
+    da_foreach(Watch_Unit, unit, units) {
+        watch_unit_free_deps(unit);
+        da_free(unit->deps);
+        free(unit->source);
+        free(unit->object);
+    }
+    units->count = 0;
+}
+
+// the strings outlive the temporary allocator, which is reset after every rebuild
+bool watch_unit_read_deps(Watch_Unit *unit) {
+    watch_unit_free_deps(unit);
+    Nob_File_Paths deps = {0};
+    bool result = read_depfile(depfile_path_for_object(unit->object), &deps);
+    da_foreach(const char*, dep, &deps) da_append(&unit->deps, strdup(*dep));
+    da_free(deps);
+    return result;
+}
+
+bool watch_units_load(Watch_Units *units) {
+    watch_units_free(units);
+    Nob_File_Paths sources = {0};
+    recursively_collect_files(SRC, &sources, allow_c_source_files);
+    qsort(sources.items, sources.count, sizeof(*sources.items), compare_paths);
+    bool result = true;
+    da_foreach(const char*, source, &sources) {
+        Watch_Unit unit = { .source = strdup(*source), .object = strdup(object_path_for_source(*source)) };
+        if (!watch_unit_read_deps(&unit)) result = false;
+        da_append(units, unit);
+    }
+    free_collected_files(&sources);
+    return result;
+}
+
+Watch_Unit *watch_unit_for_source(Watch_Units *units, const char *source) {
+    da_foreach(Watch_Unit, unit, units) {
+        if (strcmp(unit->source, source) == 0) return unit;
+    }
+    return NULL;
+}
+
+bool watch_unit_depends_on(Watch_Unit *unit, const char *path) {
+    da_foreach(const char*, dep, &unit->deps) {
+        if (strcmp(*dep, path) == 0) return true;
+    }
+    return false;
+}
+
+bool watch_add_dir(int fd, Watch_Dirs *dirs, const char *path, bool recursive) {
+    int wd = inotify_add_watch(fd, path, WATCH_EVENTS);
+    if (wd < 0) {
+        nob_log(NOB_ERROR, "Could not watch %s: %s", path, strerror(errno));
+        return false;
+    }
+    da_append(dirs, ((Watch_Dir) { .wd = wd, .path = strdup(path) }));
+    if (!recursive) return true;
+
+    Nob_File_Paths children = {0};
+    if (!read_entire_dir(path, &children)) return false;
+    bool result = true;
+    da_foreach(const char*, child, &children) {
+        if (strcmp(*child, ".") == 0 || strcmp(*child, "..") == 0) continue;
+        const char *child_path = temp_sprintf("%s/%s", path, *child);
+        if (get_file_type(child_path) != FILE_DIRECTORY) continue;
+        if (!watch_add_dir(fd, dirs, child_path, true)) result = false;
+    }
+    da_free(children);
+    return result;
+}
+
+const char *watch_dir_path(Watch_Dirs *dirs, int wd) {
+    da_foreach(Watch_Dir, dir, dirs) {
+        if (dir->wd == wd) return dir->path;
+    }
+    return NULL;
+}
+
+// Reads the events until none came for WATCH_SETTLE_MS and appends the changed paths.
+// Only nob.c is of interest in the top folder, which the linker writes main.app into.
+// Waits up to timeout ms for the first change, -1 waits forever
+bool watch_read_changes(int fd, Watch_Dirs *dirs, Nob_File_Paths *changed, int timeout) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            nob_log(NOB_ERROR, "Could not wait for changes: %s", strerror(errno));
+            return false;
+        }
+        if (ready == 0) return true;
+
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            nob_log(NOB_ERROR, "Could not read the changes: %s", strerror(errno));
+            return false;
+        }
+        for (char *p = buffer; p < buffer + n;) {
+            struct inotify_event *event = (struct inotify_event*)p;
+            p += sizeof(*event) + event->len;
+            const char *dir = watch_dir_path(dirs, event->wd);
+            if (dir == NULL || event->len == 0) continue;
+            if (strcmp(dir, ".") == 0) {
+                if (strcmp(event->name, "nob.c") == 0) da_append(changed, "nob.c");
+                if (strcmp(event->name, "env") == 0) da_append(changed, "env");
+                continue;
+            }
+            const char *path = temp_sprintf("%s/%s", dir, event->name);
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                if (!watch_add_dir(fd, dirs, path, true)) return false;
+            }
+            da_append(changed, path);
+        }
+        timeout = WATCH_SETTLE_MS;
+    }
+}
+
+void watch_stop_app(Nob_Proc *app) {
+    if (*app == INVALID_PROC) return;
+    kill(*app, SIGTERM);
+    waitpid(*app, NULL, 0);
+    *app = INVALID_PROC;
+}
+
+Nob_Proc watch_start_app(void) {
+    cmd_append(&cmd, "./"EXE_NAME);
+    Nob_Proc app = cmd_start_process(cmd, NULL, NULL, NULL);
+    cmd.count = 0;
+    return app;
+}
+
+typedef enum {
+    WATCH_NOTHING,
+    WATCH_COMPILE,  // only the units that depend on the changes have to be compiled
+    WATCH_FULL,     // sources were added or removed, or the build owns the dependencies itself
+    WATCH_RESTART,  // nob.c changed, nob has to rebuild itself
+} Watch_Action;
+
+Watch_Action watch_classify_changes(Watch_Units *units, Nob_File_Paths changed, bool *affected) {
+    Watch_Action action = WATCH_NOTHING;
+    memset(affected, 0, units->count * sizeof(*affected));
+    da_foreach(const char*, path, &changed) {
+        if (strcmp(*path, "nob.c") == 0) return WATCH_RESTART;
+
+        String_View sv = sv_from_cstr(*path);
+        bool source = sv_end_with(sv, ".c");
+        if (!source && !sv_end_with(sv, ".h")) continue;
+
+        Watch_Unit *unit = source ? watch_unit_for_source(units, *path) : NULL;
+        if (source && (unit == NULL || !file_exists(*path))) return WATCH_FULL;
+        if (config.unity || config.pch) return WATCH_FULL;
+
+        // include/ is passed with -isystem and system headers are left out of the depfiles
+        bool system_header = sv_starts_with(sv, sv_from_cstr("include/"));
+        for (size_t i = 0; i < units->count; ++i) {
+            if (system_header || watch_unit_depends_on(&units->items[i], *path)) {
+                affected[i] = true;
+                action = WATCH_COMPILE;
+            }
+        }
+    }
+    return action;
+}
+
+bool watch_compile_and_link(Watch_Units *units, bool *affected) {
+    Nob_Procs procs = {0};
+    Nob_File_Paths objects = {0};
+    size_t jobs = get_jobs_count();
+    bool result = true;
+
+    for (size_t i = 0; i < units->count; ++i) {
+        Watch_Unit *unit = &units->items[i];
+        da_append(&objects, unit->object);
+        if (!affected[i]) continue;
+
+        // stale outputs are removed first, the way nob_cache_fetch() does on a miss, so no half
+        // written object or depfile of a failed compile is left behind looking fresh
+        const char *depfile = depfile_path_for_object(unit->object);
+        if (file_exists(unit->object) == 1 && !delete_file(unit->object)) return_defer(false);
+        if (file_exists(depfile) == 1 && !delete_file(depfile)) return_defer(false);
+
+        app_compile_cmd();
+        nob_cc_depfile(&cmd, depfile);
+        cmd_append(&cmd, "-c", unit->source, "-o", unit->object);
+        Nob_Proc proc = cmd_start_process(cmd, NULL, NULL, NULL);
+        cmd.count = 0;
+        if (!procs_append_with_flush(&procs, proc, jobs)) result = false;
+    }
+    if (!procs_wait_and_reset(&procs)) result = false;
+    if (!result) return_defer(false);
+
+    for (size_t i = 0; i < units->count; ++i) {
+        if (affected[i] && !watch_unit_read_deps(&units->items[i])) return_defer(false);
+    }
+    if (!link_app_native(objects)) return_defer(false);
+
+defer:
+    if (!procs_wait_and_reset(&procs)) result = false;
+    da_free(procs);
+    da_free(objects);
+    return result;
+}
+
+bool watch_app(Config config, char **nob_argv) {
+    if (config.platform != PLATFORM_NATIVE || config.pgo) {
+        nob_log(NOB_ERROR, "Watch mode only supports native builds without -pgo.");
+        return false;
+    }
+
+    bool result = true;
+    Watch_Units units = {0};
+    Watch_Dirs dirs = {0};
+    Nob_File_Paths changed = {0};
+    bool *affected = NULL;
+    Nob_Proc app = INVALID_PROC;
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        nob_log(NOB_ERROR, "Could not initialize inotify: %s", strerror(errno));
+        return false;
+    }
+    // watch before the first build, so edits made during it are not lost
+    if (!watch_add_dir(fd, &dirs, SRC, true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, "include", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, ".", false)) return_defer(false);
+    // what sdl_sources_changed() checks
+    if (!watch_add_dir(fd, &dirs, SDL_PATH, false)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/cmake", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/include", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/src", true)) return_defer(false);
+    if (!mkdir_if_not_exists(OBJ_FOLDER)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, OBJ_FOLDER, true)) return_defer(false);
+
+    if (build_app_config(config)) {
+        app = watch_start_app();
+    } else {
+        nob_log(NOB_ERROR, "Build failed, waiting for changes.");
+    }
+    // objects that failed to build have no depfile yet, they are compiled once anything changes
+    watch_units_load(&units);
+    finish_compdb();
+    temp_reset();
+
+    nob_log(NOB_INFO, "Watching for changes...");
+    for (;;) {
+        changed.count = 0;
+        if (!watch_read_changes(fd, &dirs, &changed, -1)) return_defer(false);
+        // the edits happened after the previous build looked at the files
+        stat_cache_reset();
+
+        unsigned long long start = get_timestamp_usec();
+        affected = realloc(affected, (units.count + 1) * sizeof(*affected));
+        assert(affected != NULL);
+
+        bool ok = true;
+        switch (watch_classify_changes(&units, changed, affected)) {
+            case WATCH_NOTHING: {
+                temp_reset();
+                continue;
+            }
+            case WATCH_RESTART: {
+                nob_log(NOB_INFO, "nob.c changed, restarting.");
+                watch_stop_app(&app);
+                close(fd);
+                execv(nob_argv[0], nob_argv);
+                nob_log(NOB_ERROR, "Could not restart %s: %s", nob_argv[0], strerror(errno));
+                return_defer(false);
+            }
+            case WATCH_FULL: {
+                ok = build_app_native(false, config.unity);
+                watch_units_load(&units);
+            } break;
+            case WATCH_COMPILE: {
+                ok = watch_compile_and_link(&units, affected);
+            } break;
+        }
+
+        if (ok) {
+            nob_log(NOB_INFO, "Rebuilt in %0.3fs, restarting "EXE_NAME".", (float)(get_timestamp_usec() - start) / 1000000.0f);
+            watch_stop_app(&app);
+            app = watch_start_app();
+        } else {
+            nob_log(NOB_ERROR, "Build failed, "EXE_NAME" keeps running the previous build.");
+        }
+        finish_compdb();
+        finish_manifest();
+        nob_log(NOB_INFO, "Watching for changes...");
+        temp_reset();
+    }
+
+defer:
+    watch_stop_app(&app);
+    close(fd);
+    free(affected);
+    watch_units_free(&units);
+    da_free(units);
+    da_free(changed);
+    return result;
+}
+
+#else
+
+bool watch_app(Config config, char **nob_argv) {
+    (void)config; (void)nob_argv;
+    nob_log(NOB_ERROR, "Watch mode uses inotify, it is only available on Linux.");
+    return false;
+}
+
+#endif // __linux__
+
+// Build daemon
+
+// `./nob daemon` starts a server in the background that answers the native builds of later `./nob`
+// calls. It keeps the stat cache, the manifest and the loaded SDL source list between the builds and
+// follows src/, include/, nob.c, the SDL sources and build/obj with inotify, so a build where nothing
+// changed is answered by looking at nothing but the app and build/.config. The client hands its
+// stdout and stderr over the socket, the daemon and the compilers it starts write straight into them.
+// Every other command runs in its own process and tells the daemon afterwards that its outputs may be
+// stale. `-f` always builds. The daemon quits when nob.c or env change and the next `./nob` does the
+// usual startup.
+#ifdef __linux__
+
+#define DAEMON_SOCKET_PATH BUILD_FOLDER"/nob.sock"
+#define DAEMON_LOG_PATH BUILD_FOLDER"/daemon.log"
+#define DAEMON_REQUEST_MAX 4096
+// the reply is one byte: 0 built or up to date, 1 failed, or this
+#define DAEMON_NOT_SERVED 2
+// how often the daemon checks that its socket is still there, `./nob clean` removes it for example
+#define DAEMON_SOCKET_CHECK_MS 1000
+
+int daemon_connect(void) {
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strncpy(addr.sun_path, DAEMON_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Hands the build to a running daemon. Returns the exit code, or -1 to build in this process.
+int daemon_client(int argc, char **argv) {
+    // only the builds of a config, `daemon stop` and `daemon dirty` go to the daemon
+    bool daemon_command = argc == 3 && strcmp(argv[1], "daemon") == 0
+        && (strcmp(argv[2], "stop") == 0 || strcmp(argv[2], "dirty") == 0);
+    if (!daemon_command && argc > 1 && (argv[1][0] != '-' || strcmp(argv[1], "-C") == 0)) return -1;
+
+    char request[DAEMON_REQUEST_MAX];
+    size_t size = 0;
+    for (int i = 1; i < argc; ++i) {
+        size_t n = strlen(argv[i]) + 1;
+        if (size + n > sizeof(request)) return -1;
+        memcpy(request + size, argv[i], n);
+        size += n;
+    }
+
+    int sock = daemon_connect();
+    if (sock < 0) return -1;
+
+    int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    union { struct cmsghdr header; char buffer[CMSG_SPACE(sizeof(fds))]; } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = { .iov_base = request, .iov_len = size };
+    // an empty datagram could not be told apart from a closed connection
+    if (size == 0) iov.iov_len = 1, request[0] = '\0';
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control.buffer, .msg_controllen = sizeof(control.buffer),
+    };
+    struct cmsghdr *header = CMSG_FIRSTHDR(&msg);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    char status = DAEMON_NOT_SERVED;
+    ssize_t n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (n >= 0) {
+        while ((n = read(sock, &status, 1)) < 0 && errno == EINTR);
+    }
+    close(sock);
+    if (n != 1 || status == DAEMON_NOT_SERVED) return -1;
+    return status;
+}
+
+// Stops a running daemon, before its socket is deleted from under it
+void daemon_stop(void) {
+    char *args[] = { "nob", "daemon", "stop", NULL };
+    daemon_client(3, args);
+}
+
+// Tells a running daemon that a command which did not go through it may have changed what it built
+void daemon_invalidate(void) {
+    char *args[] = { "nob", "daemon", "dirty", NULL };
+    daemon_client(3, args);
+}
 
+typedef struct {
+    bool dirty;                          // something changed since the last good build
+    bool stop;
+    Nob_String_Builder last_request;     // of the last good build
+    // what the last good build left behind, a command that bypassed the daemon (watch, sdl-direct)
+    // may have relinked the app or built another config since
+    Nob_File_Stat last_exe;
+    Nob_File_Stat last_config;
+} Daemon;
+
+// Stats path past the cache, false if it does not exist
+bool daemon_output_stat(const char *path, Nob_File_Stat *st) {
+    stat_cache_forget(path);
+    return file_stat(path, st);
+}
+
+bool daemon_output_unchanged(const char *path, const Nob_File_Stat *last) {
+    Nob_File_Stat st;
+    if (!daemon_output_stat(path, &st)) return false;
+    return st.mtime_ns == last->mtime_ns && st.size == last->size && st.inode == last->inode;
+}
+
+// Builds what the request asks for, with stdout and stderr going to the client
+char daemon_handle(Daemon *daemon, char *request, size_t size) {
+    char *args[64];
+    int argc = 0;
+    if (request[size - 1] != '\0') return DAEMON_NOT_SERVED;
+    for (size_t i = 0; i < size; i += strlen(request + i) + 1) {
+        if (request[i] == '\0' && size == 1) break;
+        if (argc == (int)ARRAY_LEN(args)) return DAEMON_NOT_SERVED;
+        args[argc++] = request + i;
+    }
+
+    if (argc == 2 && strcmp(args[0], "daemon") == 0 && strcmp(args[1], "stop") == 0) {
+        nob_log(NOB_INFO, "Stopping the daemon.");
+        daemon->stop = true;
+        return 0;
+    }
+    if (argc == 2 && strcmp(args[0], "daemon") == 0 && strcmp(args[1], "dirty") == 0) {
+        daemon->dirty = true;
+        return 0;
+    }
+
+    Config request_config = {0};
+    char **argv = args;
+    if (!parse_config_from_args(&argc, &argv, &request_config)) return 1;
+    // the app would outlive the client as a child of the daemon
+    if (request_config.platform != PLATFORM_NATIVE || request_config.should_run) return DAEMON_NOT_SERVED;
+
+    bool same = daemon->last_request.count == size && memcmp(daemon->last_request.items, request, size) == 0;
+    if (!daemon->dirty && same && !request_config.force_rebuild
+        && daemon_output_unchanged(EXE_NAME, &daemon->last_exe)
+        && daemon_output_unchanged(CONFIG_FILE_PATH, &daemon->last_config)) {
+        nob_log(NOB_INFO, "Up to date.");
+        return 0;
+    }
+
+    unsigned long long start = get_timestamp_usec();
+    // the inputs changed since they were stat'ed, and so did whatever was built from them
+    if (daemon->dirty) stat_cache_reset();
+    daemon->dirty = true;
+    config = request_config;
+    bool ok = build_app_config(request_config);
+    finish_compdb();
+    finish_manifest();
+    if (!ok) return 1;
+    if (!daemon_output_stat(EXE_NAME, &daemon->last_exe)) return 0;
+    if (!daemon_output_stat(CONFIG_FILE_PATH, &daemon->last_config)) return 0;
+
+    daemon->dirty = false;
+    daemon->last_request.count = 0;
+    sb_append_buf(&daemon->last_request, request, size);
+    nob_log(NOB_INFO, "Built by the daemon in %0.3fs.", (float)(get_timestamp_usec() - start) / 1000000.0f);
+    return 0;
+}
+
+// Marks the daemon dirty for the changes inotify reported. Right after a build the objects it wrote
+// itself are left out, edits anywhere else still count.
+bool daemon_read_changes(Daemon *daemon, int fd, Watch_Dirs *dirs, Nob_File_Paths *changed, bool built) {
+    changed->count = 0;
+    if (!watch_read_changes(fd, dirs, changed, 0)) return false;
+    da_foreach(const char*, path, changed) {
+        if (strcmp(*path, "nob.c") == 0 || strcmp(*path, "env") == 0) {
+            nob_log(NOB_INFO, "%s changed, stopping the daemon.", *path);
+            daemon->stop = true;
+        }
+        if (built && strncmp(*path, OBJ_FOLDER"/", strlen(OBJ_FOLDER"/")) == 0) continue;
+        daemon->dirty = true;
+    }
     return true;
 }
 
+void daemon_serve(Daemon *daemon, int client) {
+    char request[DAEMON_REQUEST_MAX];
+    int fds[2] = { -1, -1 };
+    union { struct cmsghdr header; char buffer[CMSG_SPACE(sizeof(fds))]; } control;
+    struct iovec iov = { .iov_base = request, .iov_len = sizeof(request) };
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control.buffer, .msg_controllen = sizeof(control.buffer),
+    };
+    ssize_t size = recvmsg(client, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr *header = size > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (header == NULL || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        nob_log(NOB_WARNING, "Dropped a request without the output of the client");
+        return;
+    }
+    memcpy(fds, CMSG_DATA(header), sizeof(fds));
+
+    fflush(stdout);
+    fflush(stderr);
+    int saved_out = dup(STDOUT_FILENO);
+    int saved_err = dup(STDERR_FILENO);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+
+    char status = daemon_handle(daemon, request, (size_t)size);
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    temp_reset();
+
+    if (write(client, &status, 1) != 1) nob_log(NOB_WARNING, "The client left before the build finished");
+}
+
+bool daemon_run(void) {
+    bool result = true;
+    Daemon daemon = { .dirty = true };
+    Watch_Dirs dirs = {0};
+    Nob_File_Paths changed = {0};
+    Nob_File_Stat socket_stat = {0};
+    bool socket_ours = false;
+    int listener = -1;
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        nob_log(NOB_ERROR, "Could not initialize inotify: %s", strerror(errno));
+        return false;
+    }
+    if (!watch_add_dir(fd, &dirs, SRC, true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, "include", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, ".", false)) return_defer(false);
+    // what sdl_sources_changed() checks
+    if (!watch_add_dir(fd, &dirs, SDL_PATH, false)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/cmake", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/include", true)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, SDL_PATH"/src", true)) return_defer(false);
+    if (!mkdir_if_not_exists(OBJ_FOLDER)) return_defer(false);
+    if (!watch_add_dir(fd, &dirs, OBJ_FOLDER, true)) return_defer(false);
+
+    listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strncpy(addr.sun_path, DAEMON_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    // a daemon that died does not remove its socket
+    unlink(DAEMON_SOCKET_PATH);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 8) < 0) {
+        nob_log(NOB_ERROR, "Could not listen on %s: %s", DAEMON_SOCKET_PATH, strerror(errno));
+        return_defer(false);
+    }
+    socket_ours = daemon_output_stat(DAEMON_SOCKET_PATH, &socket_stat);
+    nob_log(NOB_INFO, "Daemon listening on %s", DAEMON_SOCKET_PATH);
+    temp_reset();
+
+    while (!daemon.stop) {
+        struct pollfd pfds[2] = {
+            { .fd = fd, .events = POLLIN },
+            { .fd = listener, .events = POLLIN },
+        };
+        if (poll(pfds, 2, DAEMON_SOCKET_CHECK_MS) < 0) {
+            if (errno == EINTR) continue;
+            nob_log(NOB_ERROR, "Could not wait for requests: %s", strerror(errno));
+            return_defer(false);
+        }
+
+        // nobody can reach the daemon anymore, or the socket belongs to another one by now
+        if (!daemon_output_unchanged(DAEMON_SOCKET_PATH, &socket_stat)) {
+            nob_log(NOB_INFO, "%s is gone, stopping the daemon.", DAEMON_SOCKET_PATH);
+            socket_ours = false;
+            return_defer(true);
+        }
+
+        // changes are read before a request is answered, so an edit made right before is never missed
+        if (!daemon_read_changes(&daemon, fd, &dirs, &changed, false)) return_defer(false);
+        if (daemon.stop) break;
+
+        if (pfds[1].revents & POLLIN) {
+            int client = accept(listener, NULL, NULL);
+            if (client < 0) continue;
+            fcntl(client, F_SETFD, FD_CLOEXEC);
+            daemon_serve(&daemon, client);
+            close(client);
+            if (!daemon_read_changes(&daemon, fd, &dirs, &changed, true)) return_defer(false);
+        }
+        temp_reset();
+    }
+
+defer:
+    if (listener >= 0) close(listener);
+    if (socket_ours) unlink(DAEMON_SOCKET_PATH);
+    close(fd);
+    sb_free(daemon.last_request);
+    da_free(changed);
+    return result;
+}
+
+// Starts the daemon in the background
+bool daemon_start(void) {
+    int sock = daemon_connect();
+    if (sock >= 0) {
+        close(sock);
+        nob_log(NOB_INFO, "The daemon is already running.");
+        return true;
+    }
+    if (!mkdir_if_not_exists(BUILD_FOLDER)) return false;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        nob_log(NOB_ERROR, "Could not fork the daemon: %s", strerror(errno));
+        return false;
+    }
+    if (pid > 0) {
+        nob_log(NOB_INFO, "Started the daemon (pid %d), it logs into %s.", (int)pid, DAEMON_LOG_PATH);
+        return true;
+    }
+
+    setsid();
+    int devnull = open("/dev/null", O_RDONLY);
+    int log = open(DAEMON_LOG_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (devnull >= 0) dup2(devnull, STDIN_FILENO);
+    if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+    }
+    if (devnull >= 0) close(devnull);
+    if (log >= 0) close(log);
+    // the process lives for as long as the session, the trace would only grow
+    nob_trace.enabled = false;
+    exit(daemon_run() ? 0 : 1);
+}
+
+#else
+
+int daemon_client(int argc, char **argv) {
+    (void)argc; (void)argv;
+    return -1;
+}
+
+void daemon_stop(void) {}
+
+void daemon_invalidate(void) {}
+
+bool daemon_start(void) {
+    nob_log(NOB_ERROR, "The daemon uses inotify and Unix sockets, it is only available on Linux.");
+    return false;
+}
+
+#endif // __linux__
+
 int main(int argc, char **argv) {
+    // a daemon answers before nob even checks whether it has to rebuild itself, it quits when nob.c changes
+    int daemon_result = daemon_client(argc, argv);
+    if (daemon_result >= 0) return daemon_result;
+
     NOB_GO_REBUILD_URSELF(argc, argv);
+    char **nob_argv = argv;
+
+    // a workspace of the test matrix, see build_app_all_configs()
+    if (argc > 2 && strcmp(argv[1], "-C") == 0) {
+        if (!set_current_dir(argv[2])) return 1;
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
 
     if (!parse_environment()) return false;
 
     shift_args(&argc, &argv);
+    nob_trace.enabled = true;
+    nob_compdb.enabled = true;
+    if (!manifest_load(MANIFEST_FILE_PATH)) return 1;
+    if (!jobserver_init(get_jobs_count())) return 1;
 
+    bool result = true;
     if (*(argv) != NULL && strcmp(*(argv), "clean") == 0) {
-        if (!build_clean_all(argc, argv) != 0) return 1;
+        // git clean removes the socket of the daemon, which would keep running unreachable
+        daemon_stop();
+        result = build_clean_all(argc, argv);
     } else if (*(argv) != NULL && strcmp(*(argv), "sdl") == 0) {
-        if (!build_sdl(true) != 0) return 1;
+        result = build_sdl(true);
+    } else if (*(argv) != NULL && strcmp(*(argv), "sdl-direct") == 0) {
+        shift_args(&argc, &argv);
+        if (!parse_config_from_args(&argc, &argv, &config)) return 1;
+        minimal_log_level = NOB_NO_LOGS;
+        mkdir_if_not_exists(BUILD_FOLDER);
+        minimal_log_level = 0;
+        result = build_sdl_direct(config.force_rebuild, config.unity);
+    } else if (*(argv) != NULL && strcmp(*(argv), "watch") == 0) {
+        shift_args(&argc, &argv);
+        if (!parse_config_from_args(&argc, &argv, &config)) return 1;
+        // the process lives for as long as the session, the trace would only grow
+        nob_trace.enabled = false;
+        result = watch_app(config, nob_argv);
+    } else if (*(argv) != NULL && strcmp(*(argv), "bench_spawn") == 0) {
+        shift_args(&argc, &argv);
+        result = bench_spawn(argc, argv);
+    } else if (*(argv) != NULL && strcmp(*(argv), "bench_walk") == 0) {
+        shift_args(&argc, &argv);
+        result = bench_walk(argc, argv);
+    } else if (*(argv) != NULL && strcmp(*(argv), "bench_map") == 0) {
+        shift_args(&argc, &argv);
+        result = bench_map(argc, argv);
+    } else if (*(argv) != NULL && strcmp(*(argv), "daemon") == 0) {
+        shift_args(&argc, &argv);
+        if (*(argv) != NULL && strcmp(*(argv), "stop") == 0) {
+            nob_log(NOB_INFO, "The daemon is not running.");
+        } else {
+            result = daemon_start();
+        }
     } else if (*(argv) != NULL && strcmp(*(argv), "test_builds") == 0) {
-        if (!build_app_all_configs()) return 1;
+        result = build_app_all_configs(nob_argv[0]);
     } else {
         if (!parse_config_from_args(&argc, &argv, &config)) return false;
-        if (!build_app_config(config)) return 1;
+        result = build_app_config(config);
     }
 
-    return 0;
+    // sdl, sdl-direct, watch, the mobile builds and the test matrix write outputs the daemon may rely on
+    if (*(argv) == NULL || (strcmp(*(argv), "clean") != 0 && strcmp(*(argv), "daemon") != 0)) daemon_invalidate();
+
+    // the trace is most interesting when the build failed or was slow, so it is written either way
+    if (*(argv) == NULL || strcmp(*(argv), "clean") != 0) finish_trace();
+    finish_compdb();
+    finish_manifest();
+    return result ? 0 : 1;
 }
@@ -34,9 +34,17 @@ SDL_Renderer* renderer = NULL;
 Uint64 sdl_frame_start = 0;
 bool should_quit = false;
 
+// set through APP_TRAINING_FRAMES by the profile guided build of nob.c, which needs the app to
+// exit on its own after a fixed workload. 0 runs until closed
+Uint64 training_frames = 0;
+Uint64 frame_count = 0;
+
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
     (void)appstate; (void)argc; (void)argv; 
 
+    const char *frames = SDL_getenv("APP_TRAINING_FRAMES");
+    if (frames != NULL) training_frames = SDL_strtoull(frames, NULL, 10);
+
     if (!SDL_Init(SDL_INIT_VIDEO)) exit(1);
 
     if (!SDL_CreateWindowAndRenderer("main", 0, 0, SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY, &window, &renderer)) {
@@ -51,6 +59,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
 SDL_AppResult SDL_AppIterate(void *appstate) {
     (void)appstate;
     if (should_quit) return SDL_APP_SUCCESS;
+    if (training_frames > 0 && frame_count++ >= training_frames) return SDL_APP_SUCCESS;
 
     SDL_RenderPresent(renderer);
     Uint64 sdl_frame_end = SDL_GetTicksNS();
@@ -0,0 +1,14 @@
+// Umbrella header that nob precompiles when building with -pch and force-includes into every
+// translation unit of the app. Only put big headers here that rarely change.
+// SDL_main.h must not be in here, it may only be included by the file with main().
+#ifndef PCH_H_
+#define PCH_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#endif // PCH_H_